@@ -0,0 +1,339 @@
+//
+//  EXCacheBenchmark.cpp
+//
+//  Created by evanxlh on 2025/7/6.
+//
+
+#include "EXCacheWorkload.h"
+#include "../Source/Cache/EXMemoryCache.h"
+#include "../Source/Cache/EXShardedMemoryCache.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ EXMemoryCache 基准测试(不依赖 GUI)。
+
+ 对每种访问序列(EXCacheWorkload)、每种缓存配置、1..N 个线程各运行一次，输出吞吐、延迟分位数、
+ 命中率与每个缓存项占用的堆内存，支持 text/json/csv 三种格式，便于比较缓存修改前后的结果:
+
+     QtWheels_bench [--format=text|json|csv] [--ops=N] [--keys=N] [--capacity=N]
+                    [--threads=N] [--seed=N] [--filter=子串]
+ */
+
+// ---- 堆内存统计: 替换全局 operator new/delete，记录当前存活的堆内存字节数 ----
+
+static std::atomic<int64_t> g_liveHeapBytes{ 0 };
+
+// 在每块内存前保存其大小，delete 时才能扣除；16 字节保证对齐不变
+static constexpr size_t HeapHeaderSize = 16;
+
+void* operator new(size_t size)
+{
+    void* block = std::malloc(size + HeapHeaderSize);
+    if (block == nullptr) throw std::bad_alloc();
+    *static_cast<size_t*>(block) = size;
+    g_liveHeapBytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+    return static_cast<char*>(block) + HeapHeaderSize;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer == nullptr) return;
+    void* block = static_cast<char*>(pointer) - HeapHeaderSize;
+    g_liveHeapBytes.fetch_sub(static_cast<int64_t>(*static_cast<size_t*>(block)), std::memory_order_relaxed);
+    std::free(block);
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete[](void* pointer) noexcept { operator delete(pointer); }
+void operator delete(void* pointer, size_t) noexcept { operator delete(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { operator delete(pointer); }
+
+// ---- 参数与结果 ----
+
+struct Options
+{
+    std::string format = "text";
+    size_t operations = 2000000;   // 每次运行的总操作数(平分给各线程)
+    uint64_t keyCount = 1000000;
+    size_t capacity = 50000;       // 缓存的 countLimit
+    size_t maxThreads = std::max<size_t>(4, std::thread::hardware_concurrency());
+    uint64_t seed = 42;
+    std::string filter;
+};
+
+struct Result
+{
+    std::string workload;
+    std::string cache;
+    size_t threads = 0;
+    size_t operations = 0;
+    double seconds = 0;
+    double opsPerSecond = 0;
+    double p50Nanoseconds = 0;
+    double p99Nanoseconds = 0;
+    double hitRatio = 0;
+    double bytesPerEntry = 0;
+    size_t count = 0;
+};
+
+// 每个缓存项的 value: 32 字节的字符串(超出 SSO，会在堆上分配)
+static const std::string& payload()
+{
+    static const std::string value(32, 'v');
+    return value;
+}
+
+// 每隔多少次操作记录一次延迟；每次都读时钟会明显拉低吞吐
+static constexpr size_t LatencySampleInterval = 32;
+
+// ---- 运行 ----
+
+template <typename Cache>
+Result runBenchmark(const Options& options, const EXCacheWorkload& workload, const std::string& cacheName,
+                    size_t threadCount)
+{
+    using Clock = std::chrono::steady_clock;
+    const bool expires = workload.kind == EXCacheWorkload::Kind::TTLChurn;
+    const int ttl = expires ? 1 : 0;
+
+    typename Cache::Config config;
+    config.countLimit = options.capacity;
+    config.expirySweepInterval = expires ? 250 : 0;
+
+    // 访问序列在计时之前生成
+    const size_t operationsPerThread = options.operations / threadCount;
+    std::vector<std::vector<uint64_t>> traces;
+    for (size_t t = 0; t < threadCount; ++t) {
+        traces.push_back(workload.generate(options.keyCount, options.capacity, operationsPerThread, options.seed, t));
+    }
+    const auto warmup = workload.generate(options.keyCount, options.capacity, options.capacity * 4,
+                                          options.seed, threadCount + 1);
+
+    const int64_t heapBefore = g_liveHeapBytes.load();
+    Cache cache(config);
+
+    // 预热: 单线程把缓存填到稳定状态，再统计每个缓存项占用的堆内存
+    for (uint64_t key : warmup) {
+        if (!cache.get(key)) {
+            cache.put(key, payload(), Cache::Shard::AutoCost, ttl);
+        }
+    }
+
+    Result result;
+    result.workload = workload.name;
+    result.cache = cacheName;
+    result.threads = threadCount;
+    result.count = cache.count();
+    result.bytesPerEntry = result.count > 0 ? double(g_liveHeapBytes.load() - heapBefore) / double(result.count) : 0;
+
+    // TTL 以秒为单位，而一次运行通常不到一秒: 等预热写入的缓存项全部过期，计时阶段从大量过期项开始，
+    // 测量惰性过期、后台清理与重新写入交织时的开销
+    if (expires) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ttl * 1000 + 100));
+    }
+
+    const EXCacheStats before = cache.stats();
+    std::vector<std::vector<uint32_t>> samples(threadCount);
+    std::atomic<size_t> ready{ 0 };
+    std::atomic<bool> starts{ false };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            const auto& trace = traces[t];
+            auto& latencies = samples[t];
+            latencies.reserve(trace.size() / LatencySampleInterval + 1);
+
+            ready.fetch_add(1);
+            while (!starts.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+
+            for (size_t i = 0; i < trace.size(); ++i) {
+                const uint64_t key = trace[i];
+                if (i % LatencySampleInterval == 0) {
+                    const auto start = Clock::now();
+                    if (!cache.get(key)) {
+                        cache.put(key, payload(), Cache::Shard::AutoCost, ttl);
+                    }
+                    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+                    latencies.push_back(static_cast<uint32_t>(std::min<int64_t>(elapsed.count(), UINT32_MAX)));
+                } else if (!cache.get(key)) {
+                    cache.put(key, payload(), Cache::Shard::AutoCost, ttl);
+                }
+            }
+        });
+    }
+
+    while (ready.load() < threadCount) {
+        std::this_thread::yield();
+    }
+    const auto start = Clock::now();
+    starts.store(true, std::memory_order_release);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.operations = operationsPerThread * threadCount;
+    result.opsPerSecond = result.seconds > 0 ? double(result.operations) / result.seconds : 0;
+
+    const EXCacheStats after = cache.stats();
+    const uint64_t hits = after.hits - before.hits;
+    const uint64_t lookups = hits + (after.misses - before.misses);
+    result.hitRatio = lookups > 0 ? double(hits) / double(lookups) : 0;
+
+    std::vector<uint32_t> latencies;
+    for (const auto& threadSamples : samples) {
+        latencies.insert(latencies.end(), threadSamples.begin(), threadSamples.end());
+    }
+    const auto percentile = [&latencies](double p) -> double {
+        if (latencies.empty()) return 0;
+        const size_t index = std::min(latencies.size() - 1, static_cast<size_t>(p * double(latencies.size())));
+        std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+        return latencies[index];
+    };
+    result.p50Nanoseconds = percentile(0.50);
+    result.p99Nanoseconds = percentile(0.99);
+    return result;
+}
+
+// EXMemoryCache 没有 Shard 类型，统一用 Cache::Shard::AutoCost 访问
+template <typename Key, typename Value, typename LockPolicy, typename TTLPolicy, typename EvictionPolicy>
+struct SingleCache : EXMemoryCache<Key, Value, LockPolicy, TTLPolicy, EvictionPolicy>
+{
+    using Shard = EXMemoryCache<Key, Value, LockPolicy, TTLPolicy, EvictionPolicy>;
+    using Shard::Shard;
+};
+
+// ---- 输出 ----
+
+static void printText(const std::vector<Result>& results)
+{
+    std::printf("%-10s %-20s %7s %14s %9s %9s %8s %11s\n",
+                "workload", "cache", "threads", "ops/s", "p50(ns)", "p99(ns)", "hit%", "bytes/entry");
+    for (const auto& r : results) {
+        std::printf("%-10s %-20s %7zu %14.0f %9.0f %9.0f %8.2f %11.1f\n",
+                    r.workload.c_str(), r.cache.c_str(), r.threads, r.opsPerSecond,
+                    r.p50Nanoseconds, r.p99Nanoseconds, r.hitRatio * 100, r.bytesPerEntry);
+    }
+}
+
+static void printCSV(const std::vector<Result>& results)
+{
+    std::printf("workload,cache,threads,operations,seconds,ops_per_second,p50_ns,p99_ns,hit_ratio,bytes_per_entry,count\n");
+    for (const auto& r : results) {
+        std::printf("%s,%s,%zu,%zu,%.6f,%.0f,%.0f,%.0f,%.6f,%.1f,%zu\n",
+                    r.workload.c_str(), r.cache.c_str(), r.threads, r.operations, r.seconds, r.opsPerSecond,
+                    r.p50Nanoseconds, r.p99Nanoseconds, r.hitRatio, r.bytesPerEntry, r.count);
+    }
+}
+
+static void printJSON(const std::vector<Result>& results)
+{
+    std::printf("[\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        std::printf("  {\"workload\": \"%s\", \"cache\": \"%s\", \"threads\": %zu, \"operations\": %zu, "
+                    "\"seconds\": %.6f, \"ops_per_second\": %.0f, \"p50_ns\": %.0f, \"p99_ns\": %.0f, "
+                    "\"hit_ratio\": %.6f, \"bytes_per_entry\": %.1f, \"count\": %zu}%s\n",
+                    r.workload.c_str(), r.cache.c_str(), r.threads, r.operations, r.seconds, r.opsPerSecond,
+                    r.p50Nanoseconds, r.p99Nanoseconds, r.hitRatio, r.bytesPerEntry, r.count,
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("]\n");
+}
+
+static bool parseOptions(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        const auto separator = argument.find('=');
+        const std::string name = argument.substr(0, separator);
+        const std::string value = separator == std::string::npos ? std::string() : argument.substr(separator + 1);
+
+        if (name == "--format" && (value == "text" || value == "json" || value == "csv")) {
+            options.format = value;
+        } else if (name == "--ops" && !value.empty()) {
+            options.operations = std::stoull(value);
+        } else if (name == "--keys" && !value.empty()) {
+            options.keyCount = std::stoull(value);
+        } else if (name == "--capacity" && !value.empty()) {
+            options.capacity = std::stoull(value);
+        } else if (name == "--threads" && !value.empty()) {
+            options.maxThreads = std::max<size_t>(1, std::stoull(value));
+        } else if (name == "--seed" && !value.empty()) {
+            options.seed = std::stoull(value);
+        } else if (name == "--filter") {
+            options.filter = value;
+        } else {
+            std::cerr << "unknown argument: " << argument << "\n"
+                      << "usage: QtWheels_bench [--format=text|json|csv] [--ops=N] [--keys=N] [--capacity=N]"
+                         " [--threads=N] [--seed=N] [--filter=substring]\n";
+            return false;
+        }
+    }
+    return options.operations > 0 && options.keyCount > 0 && options.capacity > 0;
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    using LRUCache = SingleCache<uint64_t, std::string, EXCacheMutexLock, EXCacheNoTTL, EXCacheLRUPolicy>;
+    using TinyLFUCache = SingleCache<uint64_t, std::string, EXCacheMutexLock, EXCacheNoTTL, EXCacheTinyLFUPolicy>;
+    using ShardedCache = EXShardedMemoryCache<uint64_t, std::string, 16, EXCacheMutexLock, EXCacheNoTTL, EXCacheLRUPolicy>;
+    using WheelTTLCache = SingleCache<uint64_t, std::string, EXCacheMutexLock, EXCacheWheelTTL, EXCacheLRUPolicy>;
+    using ShardedWheelTTLCache = EXShardedMemoryCache<uint64_t, std::string, 16, EXCacheMutexLock, EXCacheWheelTTL, EXCacheLRUPolicy>;
+
+    using Run = std::function<Result(const EXCacheWorkload&, const std::string&, size_t)>;
+    const std::vector<std::pair<std::string, Run>> cacheRuns = {
+        { "lru", [&options](auto& w, auto& n, size_t t) { return runBenchmark<LRUCache>(options, w, n, t); } },
+        { "tinylfu", [&options](auto& w, auto& n, size_t t) { return runBenchmark<TinyLFUCache>(options, w, n, t); } },
+        { "sharded16-lru", [&options](auto& w, auto& n, size_t t) { return runBenchmark<ShardedCache>(options, w, n, t); } },
+    };
+    // TTL 抖动只对带时间轮的缓存有意义
+    const std::vector<std::pair<std::string, Run>> ttlRuns = {
+        { "lru-wheel-ttl", [&options](auto& w, auto& n, size_t t) { return runBenchmark<WheelTTLCache>(options, w, n, t); } },
+        { "sharded16-wheel-ttl", [&options](auto& w, auto& n, size_t t) { return runBenchmark<ShardedWheelTTLCache>(options, w, n, t); } },
+    };
+
+    std::vector<Result> results;
+    for (const auto& workload : EXCacheWorkload::all()) {
+        const auto& runs = workload.kind == EXCacheWorkload::Kind::TTLChurn ? ttlRuns : cacheRuns;
+        for (size_t threads = 1; threads <= options.maxThreads; threads *= 2) {
+            for (const auto& [name, run] : runs) {
+                const std::string id = workload.name + "/" + name + "/" + std::to_string(threads);
+                if (!options.filter.empty() && id.find(options.filter) == std::string::npos) continue;
+
+                results.push_back(run(workload, name, threads));
+                if (options.format == "text") {
+                    std::cerr << "finished " << id << "\n";
+                }
+            }
+        }
+    }
+
+    if (options.format == "json") {
+        printJSON(results);
+    } else if (options.format == "csv") {
+        printCSV(results);
+    } else {
+        printText(results);
+    }
+    return 0;
+}
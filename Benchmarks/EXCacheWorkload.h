@@ -0,0 +1,111 @@
+//
+//  EXCacheWorkload.h
+//
+//  Created by evanxlh on 2025/7/6.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// Zipf 分布的 key 生成器: 预先计算累积分布，二分查找采样
+class ZipfGenerator
+{
+public:
+    ZipfGenerator(uint64_t keyCount, double skew)
+        : m_cdf(keyCount)
+    {
+        double sum = 0;
+        for (uint64_t i = 0; i < keyCount; ++i) {
+            sum += 1.0 / std::pow(double(i + 1), skew);
+            m_cdf[i] = sum;
+        }
+        for (auto& value : m_cdf) {
+            value /= sum;
+        }
+    }
+
+    template <typename Rng>
+    uint64_t next(Rng& rng) const
+    {
+        const double u = std::uniform_real_distribution<double>(0, 1)(rng);
+        return static_cast<uint64_t>(std::lower_bound(m_cdf.begin(), m_cdf.end(), u) - m_cdf.begin());
+    }
+
+private:
+    std::vector<double> m_cdf;
+};
+
+/**
+ 基准测试的访问序列: 每个操作是一次 read-through 访问(get，未命中时 put)，与图片加载器使用缓存的方式相同。
+ 访问序列在计时之前按 (seed, 线程下标) 生成，同样的参数每次得到完全相同的序列。
+ */
+struct EXCacheWorkload
+{
+    enum class Kind
+    {
+        Uniform,   // key 在 [0, keyCount) 上均匀分布
+        Zipf,      // Zipf(skew) 分布的热点访问
+        Scan,      // Zipf(skew) 热点访问中周期性插入一次长扫描(每个 key 只出现一次)
+        TTLChurn   // Zipf(skew) 访问，写入的缓存项带很短的 TTL，不断过期、重新写入
+    };
+
+    std::string name;
+    Kind kind = Kind::Uniform;
+    double skew = 0;
+
+    // 生成第 `threadIndex` 个线程的访问序列
+    std::vector<uint64_t> generate(uint64_t keyCount, size_t capacity, size_t operations,
+                                   uint64_t seed, size_t threadIndex) const
+    {
+        std::mt19937_64 rng(seed * 1000003 + threadIndex);
+        std::vector<uint64_t> trace;
+        trace.reserve(operations);
+
+        if (kind == Kind::Uniform) {
+            std::uniform_int_distribution<uint64_t> distribution(0, keyCount - 1);
+            while (trace.size() < operations) {
+                trace.push_back(distribution(rng));
+            }
+            return trace;
+        }
+
+        const ZipfGenerator zipf(keyCount, skew);
+        if (kind != Kind::Scan) {
+            while (trace.size() < operations) {
+                trace.push_back(zipf.next(rng));
+            }
+            return trace;
+        }
+
+        // 每 10 万次热点访问后扫描 2 倍容量的冷 key；不同线程扫描不同的 key 区间
+        const size_t scanLength = capacity * 2;
+        uint64_t scanKey = keyCount + threadIndex * (uint64_t(1) << 40);
+        while (trace.size() < operations) {
+            for (size_t i = 0; i < 100000 && trace.size() < operations; ++i) {
+                trace.push_back(zipf.next(rng));
+            }
+            for (size_t i = 0; i < scanLength && trace.size() < operations; ++i) {
+                trace.push_back(scanKey++);
+            }
+        }
+        return trace;
+    }
+
+    static std::vector<EXCacheWorkload> all()
+    {
+        return {
+            { "uniform", Kind::Uniform, 0 },
+            { "zipf-0.7", Kind::Zipf, 0.7 },
+            { "zipf-0.9", Kind::Zipf, 0.9 },
+            { "zipf-1.1", Kind::Zipf, 1.1 },
+            { "scan", Kind::Scan, 0.9 },
+            { "ttl-churn", Kind::TTLChurn, 0.9 },
+        };
+    }
+};
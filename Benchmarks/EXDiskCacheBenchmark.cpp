@@ -0,0 +1,589 @@
+//
+//  EXDiskCacheBenchmark.cpp
+//
+//  Created by evanxlh on 2025/7/6.
+//
+
+#include "EXCacheWorkload.h"
+#include "../Source/ImageLoader/EXDiskBlobStore.h"
+
+#include <QCryptographicHash>
+#include <QBuffer>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QThread>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ 磁盘缓存基准测试(依赖 Qt Core 与 Qt Gui 的 QImage)。
+
+ 比较每个缓存项一个文件(EXDiskBlobStore 之前的实现)与 EXDiskBlobStore 在不同缓存项数量下的
+ 写入吞吐、随机读取延迟分位数与淘汰 10% 数据的耗时:
+
+     QtWheels_diskbench [--format=text|json|csv] [--entries=N[,N...]] [--value-size=N]
+                        [--reads=N] [--dir=路径] [--seed=N] [--filter=子串]
+
+ 默认在 10000、100000、1000000 个缓存项下各运行一次；1000000 个缓存项需要约 entries * value-size 的磁盘空间。
+
+ 另外在相同的大小上限下回放 read-through 访问序列(读取未命中时写入，超出上限时淘汰到 90%)，比较两者的命中率:
+ 每个缓存项一个文件按修改时间淘汰，EXDiskBlobStore 按读取次数与最后读取时间淘汰。
+
+     [--trace-keys=N] [--trace-ops=N] [--trace-value-size=N] [--trace-capacity=百分比]
+
+ 最后比较处理后的缩略图的两种保存格式从 EXDiskBlobStore 命中到得到 QImage 的耗时: 未压缩的预乘像素(拷贝一次)
+ 与 PNG(解码)，格式与 EXImageLoader 保存的相同:
+
+     [--variant-size=边长] [--variant-entries=N]
+ */
+
+struct Options
+{
+    std::string format = "text";
+    std::vector<qint64> entryCounts = { 10000, 100000, 1000000 };
+    qint64 valueSize = 2048;
+    qint64 reads = 100000;
+    QString directory = QDir::temp().filePath("QtWheels_diskbench");
+    quint64 seed = 42;
+    std::string filter;
+
+    qint64 traceKeys = 20000;
+    qint64 traceOperations = 100000;
+    qint64 traceValueSize = 16 * 1024;
+    qint64 traceCapacityPercent = 25;   // 大小上限占全部 key 数据量的百分比
+
+    int variantSize = 200;
+    qint64 variantEntries = 2000;
+};
+
+struct Result
+{
+    std::string store;
+    qint64 entries = 0;
+    double writeSeconds = 0;
+    double writesPerSecond = 0;
+    double writeMegabytesPerSecond = 0;
+    double readP50Microseconds = 0;
+    double readP99Microseconds = 0;
+    double evictSeconds = 0;
+    qint64 diskBytes = 0;
+};
+
+struct TraceResult
+{
+    std::string store;
+    std::string workload;
+    qint64 keys = 0;
+    qint64 operations = 0;
+    double seconds = 0;
+    double hitRatio = 0;
+};
+
+struct VariantResult
+{
+    std::string format;
+    int size = 0;
+    qint64 entries = 0;
+    qint64 bytesPerEntry = 0;
+    double hitP50Microseconds = 0;
+    double hitP99Microseconds = 0;
+};
+
+/**
+ 被测试的存储。trim() 按各自的淘汰策略淘汰到 `targetSize`，可以在后台进行，waitForTrim() 等待它完成。
+ */
+struct Store
+{
+    std::function<void(const QString& key, const QByteArray& value)> write;
+    std::function<bool(const QString& key)> read;
+    std::function<void(qint64 targetSize)> trim;
+    std::function<void()> waitForTrim;
+    std::function<qint64()> totalSize;
+    std::function<qint64()> diskBytes;
+};
+
+using Clock = std::chrono::steady_clock;
+
+static QString keyAt(qint64 index)
+{
+    return QString("https://example.com/images/%1.jpg").arg(index);
+}
+
+static qint64 directorySize(const QString& path)
+{
+    qint64 size = 0;
+    QDirIterator it(path, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        size += it.fileInfo().size();
+    }
+    return size;
+}
+
+// ---- 每个缓存项一个文件: 文件名是 key 的 MD5，淘汰时列出目录、按修改时间删除最旧的文件 ----
+
+static Store makeFileStore(const QString& directory)
+{
+    const auto path = [directory](const QString& key) {
+        return directory + "/" + QString::fromLatin1(QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Md5).toHex());
+    };
+    // 基准测试只写入不存在的 key，总大小在内存中累加，不必每次统计目录
+    const auto totalSize = std::make_shared<qint64>(0);
+
+    Store store;
+    store.write = [path, totalSize](const QString& key, const QByteArray& value) {
+        QFile file(path(key));
+        if (file.open(QIODevice::WriteOnly)) {
+            *totalSize += file.write(value);
+        }
+    };
+    store.read = [path](const QString& key) {
+        QFile file(path(key));
+        return file.open(QIODevice::ReadOnly) && !file.readAll().isEmpty();
+    };
+    store.trim = [directory, totalSize](qint64 targetSize) {
+        QFileInfoList files = QDir(directory).entryInfoList(QDir::Files);
+        std::sort(files.begin(), files.end(), [](const QFileInfo& a, const QFileInfo& b) {
+            return a.lastModified() < b.lastModified();
+        });
+        for (const QFileInfo& file : files) {
+            if (*totalSize <= targetSize) break;
+            if (QFile::remove(file.absoluteFilePath())) {
+                *totalSize -= file.size();
+            }
+        }
+    };
+    store.waitForTrim = []() {};
+    store.totalSize = [totalSize]() { return *totalSize; };
+    store.diskBytes = [directory]() { return directorySize(directory); };
+    return store;
+}
+
+// ---- EXDiskBlobStore ----
+
+static Store makeBlobStore(EXDiskBlobStore& blobStore, const QString& directory)
+{
+    blobStore.open(directory);
+    while (!blobStore.isReady()) {
+        QThread::msleep(1);
+    }
+
+    Store store;
+    store.write = [&blobStore](const QString& key, const QByteArray& value) { blobStore.write(key, value); };
+    store.read = [&blobStore](const QString& key) {
+        const auto blob = blobStore.read(key);
+        return blob.has_value() && blob->size > 0;
+    };
+    store.trim = [&blobStore](qint64 targetSize) { blobStore.trim(targetSize); };
+    store.waitForTrim = [&blobStore]() { blobStore.waitForMaintenance(); };
+    store.totalSize = [&blobStore]() { return blobStore.totalSize(); };
+    store.diskBytes = [directory]() { return directorySize(directory); };
+    return store;
+}
+
+// ---- 运行 ----
+
+static double percentileOf(std::vector<double>& latencies, double p)
+{
+    if (latencies.empty()) return 0;
+    const size_t index = std::min(latencies.size() - 1, static_cast<size_t>(p * double(latencies.size())));
+    std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+    return latencies[index];
+}
+
+static Result runBenchmark(const Options& options, const std::string& name, Store store, qint64 entries)
+{
+    Result result;
+    result.store = name;
+    result.entries = entries;
+
+    QByteArray value(static_cast<int>(options.valueSize), Qt::Uninitialized);
+    std::mt19937_64 random(options.seed);
+    for (char& byte : value) {
+        byte = static_cast<char>(random());
+    }
+
+    // 写入: 每次改动开头的字节，避免文件系统或存储对相同内容做特殊处理
+    const auto writeStart = Clock::now();
+    for (qint64 i = 0; i < entries; ++i) {
+        std::memcpy(value.data(), &i, std::min<size_t>(sizeof(i), value.size()));
+        store.write(keyAt(i), value);
+    }
+    result.writeSeconds = std::chrono::duration<double>(Clock::now() - writeStart).count();
+    result.writesPerSecond = result.writeSeconds > 0 ? double(entries) / result.writeSeconds : 0;
+    result.writeMegabytesPerSecond = result.writeSeconds > 0
+        ? double(entries) * double(options.valueSize) / (1024.0 * 1024.0) / result.writeSeconds : 0;
+    result.diskBytes = store.diskBytes();
+
+    // 随机读取: 每次都计时，读取的文件在页缓存中，测量的是查找与打开/映射的开销
+    std::uniform_int_distribution<qint64> pick(0, entries - 1);
+    std::vector<double> latencies;
+    latencies.reserve(static_cast<size_t>(options.reads));
+    for (qint64 i = 0; i < options.reads; ++i) {
+        const QString key = keyAt(pick(random));
+        const auto start = Clock::now();
+        store.read(key);
+        latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    result.readP50Microseconds = percentileOf(latencies, 0.50);
+    result.readP99Microseconds = percentileOf(latencies, 0.99);
+
+    // 淘汰最早写入的 10%
+    const auto evictStart = Clock::now();
+    store.trim(store.totalSize() / 10 * 9);
+    store.waitForTrim();
+    result.evictSeconds = std::chrono::duration<double>(Clock::now() - evictStart).count();
+    return result;
+}
+
+static TraceResult runTrace(const Options& options, const std::string& name, Store store,
+                            const EXCacheWorkload& workload)
+{
+    const qint64 maxSize = options.traceKeys * options.traceValueSize * options.traceCapacityPercent / 100;
+    const size_t capacity = static_cast<size_t>(options.traceKeys * options.traceCapacityPercent / 100);
+    const auto trace = workload.generate(options.traceKeys, capacity, options.traceOperations, options.seed, 0);
+    const QByteArray value(static_cast<int>(options.traceValueSize), 'v');
+
+    // 与图片加载器相同: 读取未命中时写入，超出上限时淘汰到上限的 90%
+    qint64 hits = 0;
+    const auto start = Clock::now();
+    for (const uint64_t index : trace) {
+        const QString key = keyAt(static_cast<qint64>(index));
+        if (store.read(key)) {
+            ++hits;
+            continue;
+        }
+        store.write(key, value);
+        if (store.totalSize() > maxSize) {
+            store.trim(maxSize / 10 * 9);
+        }
+    }
+    store.waitForTrim();
+
+    TraceResult result;
+    result.store = name;
+    result.workload = workload.name;
+    result.keys = options.traceKeys;
+    result.operations = static_cast<qint64>(trace.size());
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.hitRatio = trace.empty() ? 0 : double(hits) / double(trace.size());
+    return result;
+}
+
+// 与 EXImageLoader 中的 EXRawPixelHeader 相同: [头 | 预乘 ARGB32 像素]
+struct RawPixelHeader
+{
+    quint32 magic;
+    quint32 width;
+    quint32 height;
+    quint32 bytesPerLine;
+};
+
+static QByteArray encodeVariant(const QImage& image, const std::string& format)
+{
+    QByteArray bytes;
+    if (format == "raw") {
+        const RawPixelHeader header{ 0x50525845, quint32(image.width()), quint32(image.height()),
+                                     quint32(image.bytesPerLine()) };
+        bytes.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        bytes.append(reinterpret_cast<const char*>(image.constBits()), int(image.sizeInBytes()));
+    } else {
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::WriteOnly);
+        image.save(&buffer, "PNG", 90);
+    }
+    return bytes;
+}
+
+static QImage decodeVariant(const EXDiskBlobStore::Blob& blob, const std::string& format)
+{
+    if (format != "raw") {
+        return QImage::fromData(blob.bytes());
+    }
+
+    RawPixelHeader header;
+    std::memcpy(&header, blob.data, sizeof(header));
+    const QImage view(reinterpret_cast<const uchar*>(blob.data + sizeof(header)),
+                      int(header.width), int(header.height), int(header.bytesPerLine),
+                      QImage::Format_ARGB32_Premultiplied);
+    return view.copy();
+}
+
+/**
+ 缩略图命中: 写入 `variantEntries` 张带透明通道的缩略图(渐变加噪声，每张不同)，
+ 随机读取并得到 QImage，每次都计时，包括读取 blob 与拷贝像素或解码
+ */
+static VariantResult runVariantHits(const Options& options, const std::string& format, EXDiskBlobStore& blobStore)
+{
+    std::mt19937_64 random(options.seed);
+    QImage image(options.variantSize, options.variantSize, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < image.height(); ++y) {
+        auto* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            const int noise = static_cast<int>(random() % 16);
+            line[x] = qPremultiply(qRgba((x + noise) & 0xFF, (y + noise) & 0xFF, ((x + y) / 2) & 0xFF, 160 + noise));
+        }
+    }
+
+    VariantResult result;
+    result.format = format;
+    result.size = options.variantSize;
+    result.entries = options.variantEntries;
+
+    qint64 totalBytes = 0;
+    for (qint64 i = 0; i < options.variantEntries; ++i) {
+        image.setPixel(0, 0, qPremultiply(qRgba(int(i & 0xFF), int((i >> 8) & 0xFF), 0, 255)));
+        const QByteArray bytes = encodeVariant(image, format);
+        totalBytes += bytes.size();
+        blobStore.write(keyAt(i), bytes);
+    }
+    result.bytesPerEntry = totalBytes / options.variantEntries;
+
+    std::uniform_int_distribution<qint64> pick(0, options.variantEntries - 1);
+    std::vector<double> latencies;
+    latencies.reserve(static_cast<size_t>(options.reads));
+    for (qint64 i = 0; i < options.reads; ++i) {
+        const QString key = keyAt(pick(random));
+        const auto start = Clock::now();
+        const auto blob = blobStore.read(key);
+        const QImage decoded = blob ? decodeVariant(*blob, format) : QImage();
+        latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        if (decoded.isNull()) {
+            std::cerr << "variant " << format << " missed " << key.toStdString() << "\n";
+        }
+    }
+    result.hitP50Microseconds = percentileOf(latencies, 0.50);
+    result.hitP99Microseconds = percentileOf(latencies, 0.99);
+    return result;
+}
+
+// ---- 输出 ----
+
+static void printText(const std::vector<Result>& results, const std::vector<TraceResult>& traces,
+                      const std::vector<VariantResult>& variants)
+{
+    std::printf("%-10s %9s %12s %9s %10s %10s %10s %12s\n",
+                "store", "entries", "writes/s", "MB/s", "p50(us)", "p99(us)", "evict(s)", "disk(MB)");
+    for (const auto& r : results) {
+        std::printf("%-10s %9lld %12.0f %9.1f %10.2f %10.2f %10.3f %12.1f\n",
+                    r.store.c_str(), static_cast<long long>(r.entries), r.writesPerSecond, r.writeMegabytesPerSecond,
+                    r.readP50Microseconds, r.readP99Microseconds, r.evictSeconds, r.diskBytes / (1024.0 * 1024.0));
+    }
+
+    std::printf("\n%-10s %-10s %9s %10s %10s %8s\n", "store", "workload", "keys", "ops", "seconds", "hit%");
+    for (const auto& t : traces) {
+        std::printf("%-10s %-10s %9lld %10lld %10.2f %8.2f\n",
+                    t.store.c_str(), t.workload.c_str(), static_cast<long long>(t.keys),
+                    static_cast<long long>(t.operations), t.seconds, t.hitRatio * 100);
+    }
+
+    std::printf("\n%-10s %9s %9s %12s %10s %10s\n", "variant", "size", "entries", "bytes", "p50(us)", "p99(us)");
+    for (const auto& v : variants) {
+        std::printf("%-10s %9d %9lld %12lld %10.2f %10.2f\n",
+                    v.format.c_str(), v.size, static_cast<long long>(v.entries), static_cast<long long>(v.bytesPerEntry),
+                    v.hitP50Microseconds, v.hitP99Microseconds);
+    }
+}
+
+static void printCSV(const std::vector<Result>& results, const std::vector<TraceResult>& traces,
+                     const std::vector<VariantResult>& variants)
+{
+    std::printf("store,entries,write_seconds,writes_per_second,write_mb_per_second,read_p50_us,read_p99_us,evict_seconds,disk_bytes\n");
+    for (const auto& r : results) {
+        std::printf("%s,%lld,%.6f,%.0f,%.2f,%.3f,%.3f,%.6f,%lld\n",
+                    r.store.c_str(), static_cast<long long>(r.entries), r.writeSeconds, r.writesPerSecond,
+                    r.writeMegabytesPerSecond, r.readP50Microseconds, r.readP99Microseconds, r.evictSeconds,
+                    static_cast<long long>(r.diskBytes));
+    }
+
+    std::printf("\nstore,workload,keys,operations,seconds,hit_ratio\n");
+    for (const auto& t : traces) {
+        std::printf("%s,%s,%lld,%lld,%.6f,%.6f\n", t.store.c_str(), t.workload.c_str(), static_cast<long long>(t.keys),
+                    static_cast<long long>(t.operations), t.seconds, t.hitRatio);
+    }
+
+    std::printf("\nvariant,size,entries,bytes_per_entry,hit_p50_us,hit_p99_us\n");
+    for (const auto& v : variants) {
+        std::printf("%s,%d,%lld,%lld,%.3f,%.3f\n", v.format.c_str(), v.size, static_cast<long long>(v.entries),
+                    static_cast<long long>(v.bytesPerEntry), v.hitP50Microseconds, v.hitP99Microseconds);
+    }
+}
+
+static void printJSON(const std::vector<Result>& results, const std::vector<TraceResult>& traces,
+                      const std::vector<VariantResult>& variants)
+{
+    std::printf("{\n\"stores\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        std::printf("  {\"store\": \"%s\", \"entries\": %lld, \"write_seconds\": %.6f, \"writes_per_second\": %.0f, "
+                    "\"write_mb_per_second\": %.2f, \"read_p50_us\": %.3f, \"read_p99_us\": %.3f, "
+                    "\"evict_seconds\": %.6f, \"disk_bytes\": %lld}%s\n",
+                    r.store.c_str(), static_cast<long long>(r.entries), r.writeSeconds, r.writesPerSecond,
+                    r.writeMegabytesPerSecond, r.readP50Microseconds, r.readP99Microseconds, r.evictSeconds,
+                    static_cast<long long>(r.diskBytes), i + 1 < results.size() ? "," : "");
+    }
+    std::printf("],\n\"traces\": [\n");
+    for (size_t i = 0; i < traces.size(); ++i) {
+        const auto& t = traces[i];
+        std::printf("  {\"store\": \"%s\", \"workload\": \"%s\", \"keys\": %lld, \"operations\": %lld, "
+                    "\"seconds\": %.6f, \"hit_ratio\": %.6f}%s\n",
+                    t.store.c_str(), t.workload.c_str(), static_cast<long long>(t.keys),
+                    static_cast<long long>(t.operations), t.seconds, t.hitRatio, i + 1 < traces.size() ? "," : "");
+    }
+    std::printf("],\n\"variants\": [\n");
+    for (size_t i = 0; i < variants.size(); ++i) {
+        const auto& v = variants[i];
+        std::printf("  {\"format\": \"%s\", \"size\": %d, \"entries\": %lld, \"bytes_per_entry\": %lld, "
+                    "\"hit_p50_us\": %.3f, \"hit_p99_us\": %.3f}%s\n",
+                    v.format.c_str(), v.size, static_cast<long long>(v.entries), static_cast<long long>(v.bytesPerEntry),
+                    v.hitP50Microseconds, v.hitP99Microseconds, i + 1 < variants.size() ? "," : "");
+    }
+    std::printf("]\n}\n");
+}
+
+static bool parseOptions(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        const auto separator = argument.find('=');
+        const std::string name = argument.substr(0, separator);
+        const std::string value = separator == std::string::npos ? std::string() : argument.substr(separator + 1);
+
+        if (name == "--format" && (value == "text" || value == "json" || value == "csv")) {
+            options.format = value;
+        } else if (name == "--entries" && !value.empty()) {
+            options.entryCounts.clear();
+            for (const auto& part : QString::fromStdString(value).split(',')) {
+                options.entryCounts.push_back(part.toLongLong());
+            }
+        } else if (name == "--value-size" && !value.empty()) {
+            options.valueSize = std::stoll(value);
+        } else if (name == "--reads" && !value.empty()) {
+            options.reads = std::stoll(value);
+        } else if (name == "--dir" && !value.empty()) {
+            options.directory = QString::fromStdString(value);
+        } else if (name == "--seed" && !value.empty()) {
+            options.seed = std::stoull(value);
+        } else if (name == "--filter") {
+            options.filter = value;
+        } else if (name == "--trace-keys" && !value.empty()) {
+            options.traceKeys = std::stoll(value);
+        } else if (name == "--trace-ops" && !value.empty()) {
+            options.traceOperations = std::stoll(value);
+        } else if (name == "--trace-value-size" && !value.empty()) {
+            options.traceValueSize = std::stoll(value);
+        } else if (name == "--trace-capacity" && !value.empty()) {
+            options.traceCapacityPercent = std::stoll(value);
+        } else if (name == "--variant-size" && !value.empty()) {
+            options.variantSize = std::stoi(value);
+        } else if (name == "--variant-entries" && !value.empty()) {
+            options.variantEntries = std::stoll(value);
+        } else {
+            std::cerr << "unknown argument: " << argument << "\n"
+                      << "usage: QtWheels_diskbench [--format=text|json|csv] [--entries=N[,N...]] [--value-size=N]"
+                         " [--reads=N] [--dir=path] [--seed=N] [--filter=substring]"
+                         " [--trace-keys=N] [--trace-ops=N] [--trace-value-size=N] [--trace-capacity=percent]"
+                         " [--variant-size=N] [--variant-entries=N]\n";
+            return false;
+        }
+    }
+    const bool validCounts = std::all_of(options.entryCounts.begin(), options.entryCounts.end(),
+                                         [](qint64 count) { return count > 0; });
+    return !options.entryCounts.empty() && validCounts && options.valueSize > 0 && options.reads >= 0
+        && options.traceKeys > 0 && options.traceOperations >= 0 && options.traceValueSize > 0
+        && options.traceCapacityPercent > 0 && options.traceCapacityPercent <= 100
+        && options.variantSize > 0 && options.variantEntries > 0;
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    // 每次运行使用空目录，`run` 在 `store` 上运行一次
+    const auto runOnEmptyStore = [&options](const std::string& id, const std::string& name,
+                                            const std::function<void(const Store&)>& run) {
+        if (!options.filter.empty() && id.find(options.filter) == std::string::npos) return;
+
+        const QString directory = options.directory + "/" + QString::fromStdString(name);
+        QDir(directory).removeRecursively();
+        QDir().mkpath(directory);
+
+        if (name == "file") {
+            run(makeFileStore(directory));
+        } else {
+            EXDiskBlobStore blobStore;
+            run(makeBlobStore(blobStore, directory));
+        }
+        QDir(directory).removeRecursively();
+
+        if (options.format == "text") {
+            std::cerr << "finished " << id << "\n";
+        }
+    };
+
+    std::vector<Result> results;
+    for (const qint64 entries : options.entryCounts) {
+        for (const std::string name : { "file", "blob" }) {
+            runOnEmptyStore(name + "/" + std::to_string(entries), name, [&](const Store& store) {
+                results.push_back(runBenchmark(options, name, store, entries));
+            });
+        }
+    }
+
+    std::vector<TraceResult> traces;
+    const std::vector<EXCacheWorkload> workloads = {
+        { "zipf-0.9", EXCacheWorkload::Kind::Zipf, 0.9 },
+        { "scan", EXCacheWorkload::Kind::Scan, 0.9 },
+    };
+    for (const auto& workload : workloads) {
+        for (const std::string name : { "file", "blob" }) {
+            runOnEmptyStore("trace/" + workload.name + "/" + name, name, [&](const Store& store) {
+                traces.push_back(runTrace(options, name, store, workload));
+            });
+        }
+    }
+
+    std::vector<VariantResult> variants;
+    for (const std::string format : { "raw", "png" }) {
+        const std::string id = "variant/" + format;
+        if (!options.filter.empty() && id.find(options.filter) == std::string::npos) continue;
+
+        const QString directory = options.directory + "/variant";
+        QDir(directory).removeRecursively();
+        QDir().mkpath(directory);
+        {
+            EXDiskBlobStore blobStore;
+            makeBlobStore(blobStore, directory);
+            variants.push_back(runVariantHits(options, format, blobStore));
+        }
+        QDir(directory).removeRecursively();
+
+        if (options.format == "text") {
+            std::cerr << "finished " << id << "\n";
+        }
+    }
+
+    if (options.format == "json") {
+        printJSON(results, traces, variants);
+    } else if (options.format == "csv") {
+        printCSV(results, traces, variants);
+    } else {
+        printText(results, traces, variants);
+    }
+    return 0;
+}
@@ -0,0 +1,440 @@
+//
+//  EXNetworkBenchmark.cpp
+//
+//  Created by evanxlh on 2025/7/6.
+//
+
+#include "../Source/ImageLoader/EXNetworkEngine.h"
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QHostAddress>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QSemaphore>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ 下载基准测试(只依赖 Qt Core 与 Qt Network)。
+
+ 在本机启动一个支持 keep-alive 的 HTTP/1.1 服务器，返回固定大小的“图片”，比较两种下载方式下载大量小图片的
+ 吞吐、延迟分位数与服务器收到的 TCP 连接数:
+
+ 1. per-request: EXNetworkEngine 之前的实现，每个下载在线程池中新建 QNetworkAccessManager 并阻塞在 QEventLoop 上；
+ 2. engine: 所有下载共用 EXNetworkEngine，同时进行的下载数与线程池大小相同。
+
+ 再按轮重放同一组图片(每轮约 10% 的图片内容变化，响应都是 max-age=0)，比较服务器发送的字节数:
+
+ 3. refetch: 没有缓存信息，每轮重新下载全部图片；
+ 4. revalidate: 保存 ETag，每轮发条件请求，内容没变的图片服务器只返回 304 响应头。
+
+     QtWheels_netbench [--format=text|json|csv] [--requests=N] [--size=N] [--concurrency=N] [--rounds=N] [--filter=子串]
+ */
+
+struct Options
+{
+    std::string format = "text";
+    int requests = 2000;
+    int bodySize = 4096;
+    int concurrency = 8;
+    int rounds = 5;
+    std::string filter;
+};
+
+struct Result
+{
+    std::string client;
+    int requests = 0;
+    int failures = 0;
+    double seconds = 0;
+    double requestsPerSecond = 0;
+    double p50Milliseconds = 0;
+    double p99Milliseconds = 0;
+    int connections = 0;
+    int notModified = 0;     // 304 响应数
+    qint64 bytesSent = 0;    // 服务器发送的字节数(响应头与内容)
+};
+
+using Clock = std::chrono::steady_clock;
+
+// ---- 本机 HTTP 服务器: 在自己的线程中运行，统计收到的连接数与发送的字节数 ----
+
+class LocalHttpServer : public QThread
+{
+public:
+    explicit LocalHttpServer(int bodySize) : m_body(bodySize, 'x') {}
+
+    // 启动并等待开始监听，返回端口
+    quint16 startListening()
+    {
+        start();
+        m_ready.acquire();
+        return m_port;
+    }
+
+    quint16 port() const { return m_port; }
+    int takeConnectionCount() { return m_connections.exchange(0); }
+    qint64 takeBytesSent() { return m_bytesSent.exchange(0); }
+
+    // 重放的轮次: 每轮约 10% 的图片内容变化(ETag 改变)
+    void setRound(int round) { m_round = round; }
+
+protected:
+    void run() override
+    {
+        QTcpServer server;
+        server.listen(QHostAddress::LocalHost, 0);
+        m_port = server.serverPort();
+
+        QObject::connect(&server, &QTcpServer::newConnection, &server, [this, &server]() {
+            while (QTcpSocket* socket = server.nextPendingConnection()) {
+                m_connections.fetch_add(1);
+                QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+                QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket]() {
+                    respond(socket);
+                });
+            }
+        });
+
+        m_ready.release();
+        exec();
+    }
+
+private:
+    // 按请求头的结尾拆分请求(可能一次收到多个)；If-None-Match 与图片当前的 ETag 相同时回复 304，否则回复内容
+    void respond(QTcpSocket* socket)
+    {
+        QByteArray buffer = socket->property("buffer").toByteArray() + socket->readAll();
+        int end = 0;
+        while ((end = buffer.indexOf("\r\n\r\n")) >= 0) {
+            const QList<QByteArray> lines = buffer.left(end).split('\n');
+            buffer.remove(0, end + 4);
+
+            const QByteArray path = lines.value(0).split(' ').value(1);
+            const int index = path.mid(path.lastIndexOf('/') + 1).split('.').value(0).toInt();
+            const QByteArray eTag = "\"" + QByteArray::number(index) + "-"
+                                    + QByteArray::number((m_round.load() + index % 10) / 10) + "\"";
+            QByteArray ifNoneMatch;
+            for (const QByteArray& line : lines) {
+                if (line.toLower().startsWith("if-none-match:")) {
+                    ifNoneMatch = line.mid(line.indexOf(':') + 1).trimmed();
+                }
+            }
+
+            const bool notModified = ifNoneMatch == eTag;
+            const QByteArray head = QByteArray(notModified ? "HTTP/1.1 304 Not Modified\r\n" : "HTTP/1.1 200 OK\r\n")
+                                    + "Content-Type: application/octet-stream\r\n"
+                                      "Connection: keep-alive\r\n"
+                                      "Cache-Control: max-age=0\r\n"
+                                      "ETag: " + eTag + "\r\n"
+                                    + (notModified ? QByteArray() : "Content-Length: " + QByteArray::number(m_body.size()) + "\r\n")
+                                    + "\r\n";
+            socket->write(head);
+            m_bytesSent.fetch_add(head.size());
+            if (!notModified) {
+                socket->write(m_body);
+                m_bytesSent.fetch_add(m_body.size());
+            }
+        }
+        socket->setProperty("buffer", buffer);
+    }
+
+    QByteArray m_body;
+    QSemaphore m_ready;
+    quint16 m_port = 0;
+    std::atomic<int> m_connections{ 0 };
+    std::atomic<qint64> m_bytesSent{ 0 };
+    std::atomic<int> m_round{ 0 };
+};
+
+// ---- 运行 ----
+
+static QUrl urlAt(quint16 port, int index)
+{
+    return QUrl(QString("http://127.0.0.1:%1/images/%2.jpg").arg(port).arg(index));
+}
+
+static void summarize(Result& result, std::vector<double>& latencies, double seconds)
+{
+    result.seconds = seconds;
+    result.requestsPerSecond = seconds > 0 ? double(result.requests) / seconds : 0;
+    const auto percentile = [&latencies](double p) -> double {
+        if (latencies.empty()) return 0;
+        const size_t index = std::min(latencies.size() - 1, static_cast<size_t>(p * double(latencies.size())));
+        std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+        return latencies[index];
+    };
+    result.p50Milliseconds = percentile(0.50);
+    result.p99Milliseconds = percentile(0.99);
+}
+
+// 每个下载新建 QNetworkAccessManager，在线程池的线程中阻塞等待
+static Result runPerRequest(const Options& options, LocalHttpServer& server)
+{
+    const quint16 port = server.port();
+    Result result;
+    result.client = "per-request";
+    result.requests = options.requests;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(options.concurrency);
+    std::mutex mutex;
+    std::vector<double> latencies;
+    std::atomic<int> failures{ 0 };
+
+    const auto start = Clock::now();
+    for (int i = 0; i < options.requests; ++i) {
+        pool.start([&, i]() {
+            const auto requestStart = Clock::now();
+            QNetworkAccessManager manager;
+            QEventLoop loop;
+            QNetworkReply* reply = manager.get(QNetworkRequest(urlAt(port, i)));
+            QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+            loop.exec();
+
+            if (reply->error() != QNetworkReply::NoError || reply->readAll().size() != options.bodySize) {
+                failures.fetch_add(1);
+            }
+            reply->deleteLater();
+
+            const double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - requestStart).count();
+            std::lock_guard<std::mutex> locker(mutex);
+            latencies.push_back(elapsed);
+        });
+    }
+    pool.waitForDone();
+
+    result.failures = failures.load();
+    summarize(result, latencies, std::chrono::duration<double>(Clock::now() - start).count());
+    return result;
+}
+
+// 共用 EXNetworkEngine，同时进行的下载数不超过 concurrency
+static Result runEngine(const Options& options, LocalHttpServer& server)
+{
+    const quint16 port = server.port();
+    Result result;
+    result.client = "engine";
+    result.requests = options.requests;
+
+    EXNetworkEngine engine;
+    QSemaphore inFlight(options.concurrency);
+    QSemaphore finished;
+    std::vector<double> latencies;   // 只在网络线程中修改
+    std::atomic<int> failures{ 0 };
+
+    const auto start = Clock::now();
+    for (int i = 0; i < options.requests; ++i) {
+        inFlight.acquire();
+        const auto requestStart = Clock::now();
+        engine.get(urlAt(port, i), ImageLoader::Priority::Medium, nullptr,
+                   [&, requestStart](const QByteArray& data, QNetworkReply::NetworkError error, const EXNetworkResponse&) {
+            if (error != QNetworkReply::NoError || data.size() != options.bodySize) {
+                failures.fetch_add(1);
+            }
+            latencies.push_back(std::chrono::duration<double, std::milli>(Clock::now() - requestStart).count());
+            inFlight.release();
+            finished.release();
+        });
+    }
+    finished.acquire(options.requests);
+
+    result.failures = failures.load();
+    summarize(result, latencies, std::chrono::duration<double>(Clock::now() - start).count());
+    return result;
+}
+
+// 按轮重放同一组图片；`revalidate` 为 true 时带上次响应的 ETag 发条件请求
+static Result runReplay(const Options& options, LocalHttpServer& server, bool revalidate)
+{
+    Result result;
+    result.client = revalidate ? "revalidate" : "refetch";
+    result.requests = options.requests * options.rounds;
+
+    EXNetworkEngine engine;
+    QSemaphore inFlight(options.concurrency);
+    QSemaphore finished;
+    std::vector<double> latencies;           // 只在网络线程中修改
+    // 第 i 个元素只在第 i 张图片的回调中修改；下一轮开始之前上一轮的回调已全部完成
+    std::vector<QByteArray> eTags(options.requests);
+    std::atomic<int> failures{ 0 };
+    std::atomic<int> notModified{ 0 };
+
+    const auto start = Clock::now();
+    for (int round = 0; round < options.rounds; ++round) {
+        server.setRound(round);
+        for (int i = 0; i < options.requests; ++i) {
+            EXNetworkEngine::RawHeaders headers;
+            if (revalidate && !eTags[i].isEmpty()) {
+                headers.append({ "If-None-Match", eTags[i] });
+            }
+
+            inFlight.acquire();
+            const auto requestStart = Clock::now();
+            engine.get(urlAt(server.port(), i), ImageLoader::Priority::Medium, nullptr,
+                       [&, i, requestStart](const QByteArray& data, QNetworkReply::NetworkError error,
+                                            const EXNetworkResponse& response) {
+                if (response.statusCode == 304) {
+                    notModified.fetch_add(1);
+                } else if (error != QNetworkReply::NoError || data.size() != options.bodySize) {
+                    failures.fetch_add(1);
+                } else {
+                    eTags[i] = response.eTag;
+                }
+                latencies.push_back(std::chrono::duration<double, std::milli>(Clock::now() - requestStart).count());
+                inFlight.release();
+                finished.release();
+            }, nullptr, headers);
+        }
+        finished.acquire(options.requests);
+    }
+
+    result.failures = failures.load();
+    result.notModified = notModified.load();
+    summarize(result, latencies, std::chrono::duration<double>(Clock::now() - start).count());
+    return result;
+}
+
+static Result runRefetch(const Options& options, LocalHttpServer& server)
+{
+    return runReplay(options, server, false);
+}
+
+static Result runRevalidate(const Options& options, LocalHttpServer& server)
+{
+    return runReplay(options, server, true);
+}
+
+// ---- 输出 ----
+
+static void printText(const std::vector<Result>& results)
+{
+    std::printf("%-12s %9s %9s %10s %10s %10s %12s %8s %14s\n",
+                "client", "requests", "failures", "req/s", "p50(ms)", "p99(ms)", "connections", "304", "bytes sent");
+    for (const auto& r : results) {
+        std::printf("%-12s %9d %9d %10.0f %10.2f %10.2f %12d %8d %14lld\n",
+                    r.client.c_str(), r.requests, r.failures, r.requestsPerSecond,
+                    r.p50Milliseconds, r.p99Milliseconds, r.connections, r.notModified,
+                    static_cast<long long>(r.bytesSent));
+    }
+}
+
+static void printCSV(const std::vector<Result>& results)
+{
+    std::printf("client,requests,failures,seconds,requests_per_second,p50_ms,p99_ms,connections,not_modified,bytes_sent\n");
+    for (const auto& r : results) {
+        std::printf("%s,%d,%d,%.6f,%.0f,%.3f,%.3f,%d,%d,%lld\n",
+                    r.client.c_str(), r.requests, r.failures, r.seconds, r.requestsPerSecond,
+                    r.p50Milliseconds, r.p99Milliseconds, r.connections, r.notModified,
+                    static_cast<long long>(r.bytesSent));
+    }
+}
+
+static void printJSON(const std::vector<Result>& results)
+{
+    std::printf("[\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        std::printf("  {\"client\": \"%s\", \"requests\": %d, \"failures\": %d, \"seconds\": %.6f, "
+                    "\"requests_per_second\": %.0f, \"p50_ms\": %.3f, \"p99_ms\": %.3f, \"connections\": %d, "
+                    "\"not_modified\": %d, \"bytes_sent\": %lld}%s\n",
+                    r.client.c_str(), r.requests, r.failures, r.seconds, r.requestsPerSecond,
+                    r.p50Milliseconds, r.p99Milliseconds, r.connections, r.notModified,
+                    static_cast<long long>(r.bytesSent), i + 1 < results.size() ? "," : "");
+    }
+    std::printf("]\n");
+}
+
+static bool parseOptions(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        const auto separator = argument.find('=');
+        const std::string name = argument.substr(0, separator);
+        const std::string value = separator == std::string::npos ? std::string() : argument.substr(separator + 1);
+
+        if (name == "--format" && (value == "text" || value == "json" || value == "csv")) {
+            options.format = value;
+        } else if (name == "--requests" && !value.empty()) {
+            options.requests = std::stoi(value);
+        } else if (name == "--size" && !value.empty()) {
+            options.bodySize = std::stoi(value);
+        } else if (name == "--concurrency" && !value.empty()) {
+            options.concurrency = std::stoi(value);
+        } else if (name == "--rounds" && !value.empty()) {
+            options.rounds = std::stoi(value);
+        } else if (name == "--filter") {
+            options.filter = value;
+        } else {
+            std::cerr << "unknown argument: " << argument << "\n"
+                      << "usage: QtWheels_netbench [--format=text|json|csv] [--requests=N] [--size=N]"
+                         " [--concurrency=N] [--rounds=N] [--filter=substring]\n";
+            return false;
+        }
+    }
+    return options.requests > 0 && options.bodySize > 0 && options.concurrency > 0 && options.rounds > 0;
+}
+
+int main(int argc, char* argv[])
+{
+    // QNetworkAccessManager 需要 QCoreApplication 实例，但不需要运行主线程的事件循环
+    QCoreApplication app(argc, argv);
+
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    LocalHttpServer server(options.bodySize);
+    server.startListening();
+
+    using Run = std::function<Result(const Options&, LocalHttpServer&)>;
+    const std::vector<std::pair<std::string, Run>> runs = {
+        { "per-request", runPerRequest },
+        { "engine", runEngine },
+        { "refetch", runRefetch },
+        { "revalidate", runRevalidate },
+    };
+
+    std::vector<Result> results;
+    for (const auto& [name, run] : runs) {
+        if (!options.filter.empty() && name.find(options.filter) == std::string::npos) continue;
+
+        server.takeConnectionCount();
+        server.takeBytesSent();
+        server.setRound(0);
+        Result result = run(options, server);
+        result.connections = server.takeConnectionCount();
+        result.bytesSent = server.takeBytesSent();
+        results.push_back(result);
+
+        if (options.format == "text") {
+            std::cerr << "finished " << name << "\n";
+        }
+    }
+
+    server.quit();
+    server.wait();
+
+    if (options.format == "json") {
+        printJSON(results);
+    } else if (options.format == "csv") {
+        printCSV(results);
+    } else {
+        printText(results);
+    }
+    return 0;
+}
@@ -0,0 +1,385 @@
+//
+//  EXCacheEvictionPolicy.h
+//
+//  Created by evanxlh on 2025/7/6.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+/**
+ EXMemoryCache 的淘汰策略。
+
+ 每个策略类型提供嵌套模板 `Engine<Nodes>`，由缓存在持锁状态下调用:
+   - `setCapacity(capacity)`: 容量(权重单位，0 表示无限制)
+   - `onInsert(nodes, index)`/`onAccess(nodes, index)`/`onRemove(nodes, index)`
+   - `onMiss(hash)`: 查找未命中
+   - `victim(nodes)`: 超出限制时选出下一个要淘汰的节点(不摘除，由缓存调用 onRemove)
+   - `reset()`: 缓存被清空
+   - `forEach(nodes, fn)`: 按淘汰顺序(最先淘汰的在前)遍历节点
+
+ `Nodes` 需要提供:
+   - `EXCachePolicyLinks& policyLinks(uint32_t index)`
+   - `size_t policyWeight(uint32_t index)`: 节点权重(按 cost 或按数量)，节点在缓存中期间不变
+   - `size_t policyHash(uint32_t index)`: 节点 key 的哈希值
+ */
+struct EXCachePolicyLinks
+{
+    uint32_t prev;
+    uint32_t next;
+    uint8_t region;
+};
+
+// 以节点下标串联的侵入式双向链表: head 为最旧，tail 为最新
+template <typename Nodes>
+class EXCacheNodeList
+{
+public:
+    static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+    uint32_t head() const { return m_head; }
+    uint32_t tail() const { return m_tail; }
+    bool isEmpty() const { return m_head == InvalidIndex; }
+
+    void pushBack(Nodes& nodes, uint32_t index)
+    {
+        auto& links = nodes.policyLinks(index);
+        links.prev = m_tail;
+        links.next = InvalidIndex;
+        if (m_tail != InvalidIndex) {
+            nodes.policyLinks(m_tail).next = index;
+        } else {
+            m_head = index;
+        }
+        m_tail = index;
+    }
+
+    void remove(Nodes& nodes, uint32_t index)
+    {
+        auto& links = nodes.policyLinks(index);
+        if (links.prev != InvalidIndex) {
+            nodes.policyLinks(links.prev).next = links.next;
+        } else {
+            m_head = links.next;
+        }
+        if (links.next != InvalidIndex) {
+            nodes.policyLinks(links.next).prev = links.prev;
+        } else {
+            m_tail = links.prev;
+        }
+    }
+
+    void moveToBack(Nodes& nodes, uint32_t index)
+    {
+        if (index == m_tail) return;
+        remove(nodes, index);
+        pushBack(nodes, index);
+    }
+
+    template <typename Fn>
+    void forEach(Nodes& nodes, Fn&& fn) const
+    {
+        for (uint32_t index = m_head; index != InvalidIndex; ) {
+            const uint32_t next = nodes.policyLinks(index).next;
+            fn(index);
+            index = next;
+        }
+    }
+
+    void reset() { m_head = m_tail = InvalidIndex; }
+
+private:
+    uint32_t m_head = InvalidIndex;
+    uint32_t m_tail = InvalidIndex;
+};
+
+/**
+ LRU: 淘汰最近最少使用的缓存项。
+ */
+struct EXCacheLRUPolicy
+{
+    template <typename Nodes>
+    class Engine
+    {
+    public:
+        void setCapacity(size_t) {}
+        void onInsert(Nodes& nodes, uint32_t index) { m_list.pushBack(nodes, index); }
+        void onAccess(Nodes& nodes, uint32_t index) { m_list.moveToBack(nodes, index); }
+        void onRemove(Nodes& nodes, uint32_t index) { m_list.remove(nodes, index); }
+        void onMiss(size_t) {}
+        uint32_t victim(Nodes&) const { return m_list.head(); }
+        void reset() { m_list.reset(); }
+
+        template <typename Fn>
+        void forEach(Nodes& nodes, Fn&& fn) const { m_list.forEach(nodes, fn); }
+
+    private:
+        EXCacheNodeList<Nodes> m_list;
+    };
+};
+
+/**
+ Count-Min Sketch 频率估计器: 每个计数器 4 bit，每个 key 映射到 4 个计数器，取最小值作为频率估计。
+ 记录次数达到 10 倍容量时所有计数器减半(老化)，使频率反映最近一段时间的访问情况。
+ */
+class EXFrequencySketch
+{
+public:
+    void ensureCapacity(size_t capacity)
+    {
+        size_t words = 64;
+        while (words < capacity) {
+            words <<= 1;
+        }
+        if (words <= m_table.size()) return;
+
+        // 新表的下标低位与旧表相同: 把旧计数器复制到对应的每个位置，扩容时不丢失已记录的频率
+        std::vector<uint64_t> table(words, 0);
+        if (!m_table.empty()) {
+            for (size_t i = 0; i < words; ++i) {
+                table[i] = m_table[i & m_mask];
+            }
+        }
+        m_table = std::move(table);
+        m_mask = words - 1;
+        m_sampleSize = words * 10;
+    }
+
+    void increment(size_t hash)
+    {
+        if (m_table.empty()) return;
+
+        bool added = false;
+        for (int i = 0; i < 4; ++i) {
+            const uint64_t h = _indexHash(hash, i);
+            uint64_t& word = m_table[h & m_mask];
+            const int shift = static_cast<int>((h >> 58) & 15) << 2;
+            if (((word >> shift) & 0xF) != 0xF) {
+                word += uint64_t(1) << shift;
+                added = true;
+            }
+        }
+
+        if (added && ++m_additions >= m_sampleSize) {
+            _age();
+        }
+    }
+
+    int frequency(size_t hash) const
+    {
+        if (m_table.empty()) return 0;
+
+        int frequency = 0xF;
+        for (int i = 0; i < 4; ++i) {
+            const uint64_t h = _indexHash(hash, i);
+            const int shift = static_cast<int>((h >> 58) & 15) << 2;
+            const int count = static_cast<int>((m_table[h & m_mask] >> shift) & 0xF);
+            frequency = count < frequency ? count : frequency;
+        }
+        return frequency;
+    }
+
+    void clear()
+    {
+        std::fill(m_table.begin(), m_table.end(), 0);
+        m_additions = 0;
+    }
+
+private:
+    static uint64_t _indexHash(size_t hash, int i)
+    {
+        static constexpr uint64_t Seeds[4] = {
+            0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL
+        };
+        uint64_t h = (static_cast<uint64_t>(hash) + Seeds[i]) * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 29;
+        return h;
+    }
+
+    void _age()
+    {
+        for (uint64_t& word : m_table) {
+            word = (word >> 1) & 0x7777777777777777ULL;
+        }
+        m_additions /= 2;
+    }
+
+private:
+    std::vector<uint64_t> m_table;
+    size_t m_mask = 0;
+    size_t m_sampleSize = 0;
+    size_t m_additions = 0;
+};
+
+/**
+ W-TinyLFU: 1% 的窗口 LRU 吸收突发的新数据，99% 的主区为分段 LRU(试用区 20% + 保护区 80%)。
+
+ 1. 新缓存项先进入窗口；窗口超出配额时，窗口中最旧的项作为候选，与主区的淘汰对象比较访问频率，
+    只有候选者的预计访问频率更高时才会替换主区的项，否则候选者被淘汰。
+ 2. 试用区的项再次被访问后晋升到保护区；保护区超出配额时，最旧的项降级回试用区。
+ 3. 访问频率由 EXFrequencySketch 估计，未命中的查找也会计入频率。
+
+ 一次性扫描大量新 key 时，这些 key 频率都很低，无法挤掉主区中的热点数据。
+ */
+struct EXCacheTinyLFUPolicy
+{
+    template <typename Nodes>
+    class Engine
+    {
+    public:
+        void setCapacity(size_t capacity)
+        {
+            m_capacity = capacity;
+            m_windowMax = capacity > 0 ? (capacity / 100 > 0 ? capacity / 100 : 1) : 0;
+            m_protectedMax = capacity > m_windowMax ? (capacity - m_windowMax) * 4 / 5 : 0;
+        }
+
+        void onInsert(Nodes& nodes, uint32_t index)
+        {
+            ++m_count;
+            m_sketch.ensureCapacity(m_count);
+            m_sketch.increment(nodes.policyHash(index));
+
+            const size_t weight = nodes.policyWeight(index);
+            m_weight += weight;
+            m_windowWeight += weight;
+            nodes.policyLinks(index).region = Window;
+            m_window.pushBack(nodes, index);
+
+            // 缓存未满时，窗口溢出的项直接进入试用区，无需竞争
+            while (m_windowWeight > m_windowMax && !m_window.isEmpty()
+                   && (m_capacity == 0 || m_weight <= m_capacity)) {
+                _moveToProbation(nodes, m_window.head());
+            }
+        }
+
+        void onAccess(Nodes& nodes, uint32_t index)
+        {
+            m_sketch.increment(nodes.policyHash(index));
+
+            auto& links = nodes.policyLinks(index);
+            switch (links.region) {
+            case Window:
+                m_window.moveToBack(nodes, index);
+                break;
+            case Probation:
+                m_probation.remove(nodes, index);
+                links.region = Protected;
+                m_protected.pushBack(nodes, index);
+                m_protectedWeight += nodes.policyWeight(index);
+                while (m_protectedWeight > m_protectedMax && m_protected.head() != index) {
+                    const uint32_t demoted = m_protected.head();
+                    m_protected.remove(nodes, demoted);
+                    m_protectedWeight -= nodes.policyWeight(demoted);
+                    nodes.policyLinks(demoted).region = Probation;
+                    m_probation.pushBack(nodes, demoted);
+                }
+                break;
+            default:
+                m_protected.moveToBack(nodes, index);
+                break;
+            }
+        }
+
+        void onRemove(Nodes& nodes, uint32_t index)
+        {
+            const size_t weight = nodes.policyWeight(index);
+            --m_count;
+            m_weight -= weight;
+
+            switch (nodes.policyLinks(index).region) {
+            case Window:
+                m_window.remove(nodes, index);
+                m_windowWeight -= weight;
+                break;
+            case Probation:
+                m_probation.remove(nodes, index);
+                break;
+            default:
+                m_protected.remove(nodes, index);
+                m_protectedWeight -= weight;
+                break;
+            }
+        }
+
+        void onMiss(size_t hash)
+        {
+            m_sketch.increment(hash);
+        }
+
+        uint32_t victim(Nodes& nodes)
+        {
+            while (m_windowWeight > m_windowMax && !m_window.isEmpty()) {
+                const uint32_t candidate = m_window.head();
+                const uint32_t mainVictim = _mainVictim();
+                if (mainVictim == InvalidIndex) {
+                    _moveToProbation(nodes, candidate);
+                    continue;
+                }
+
+                // 候选者预计访问更频繁时才允许它替换主区的项
+                if (m_sketch.frequency(nodes.policyHash(candidate)) > m_sketch.frequency(nodes.policyHash(mainVictim))) {
+                    _moveToProbation(nodes, candidate);
+                    return mainVictim;
+                }
+                return candidate;
+            }
+
+            const uint32_t mainVictim = _mainVictim();
+            return mainVictim != InvalidIndex ? mainVictim : m_window.head();
+        }
+
+        void reset()
+        {
+            m_window.reset();
+            m_probation.reset();
+            m_protected.reset();
+            m_sketch.clear();
+            m_count = m_weight = m_windowWeight = m_protectedWeight = 0;
+        }
+
+        template <typename Fn>
+        void forEach(Nodes& nodes, Fn&& fn) const
+        {
+            m_probation.forEach(nodes, fn);
+            m_protected.forEach(nodes, fn);
+            m_window.forEach(nodes, fn);
+        }
+
+    private:
+        static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+        enum Region : uint8_t { Window, Probation, Protected };
+
+        uint32_t _mainVictim() const
+        {
+            return !m_probation.isEmpty() ? m_probation.head() : m_protected.head();
+        }
+
+        void _moveToProbation(Nodes& nodes, uint32_t index)
+        {
+            m_window.remove(nodes, index);
+            m_windowWeight -= nodes.policyWeight(index);
+            nodes.policyLinks(index).region = Probation;
+            m_probation.pushBack(nodes, index);
+        }
+
+    private:
+        EXCacheNodeList<Nodes> m_window;
+        EXCacheNodeList<Nodes> m_probation;
+        EXCacheNodeList<Nodes> m_protected;
+        EXFrequencySketch m_sketch;
+        size_t m_capacity = 0;
+        size_t m_windowMax = 0;
+        size_t m_protectedMax = 0;
+        size_t m_count = 0;
+        size_t m_weight = 0;
+        size_t m_windowWeight = 0;
+        size_t m_protectedWeight = 0;
+    };
+};
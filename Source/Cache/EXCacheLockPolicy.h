@@ -0,0 +1,91 @@
+//
+//  EXCacheLockPolicy.h
+//
+//  Created by evanxlh on 2025/7/6.
+//
+
+#pragma once
+
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <thread>
+
+/**
+ EXMemoryCache 的加锁策略(编译期选择)。
+
+ 每个策略都满足 Lockable/SharedLockable 要求(lock/unlock/try_lock/lock_shared/try_lock_shared/unlock_shared)，
+ 缓存用 std::unique_lock 保护会修改状态的操作，用 std::shared_lock 保护只读操作。
+ `isThreadSafe = false` 的策略所有操作都是空操作，编译后不会留下任何加锁代码。
+ */
+struct EXCacheNoLock
+{
+    static constexpr bool isThreadSafe = false;
+
+    void lock() {}
+    void unlock() {}
+    bool try_lock() { return true; }
+    void lock_shared() {}
+    bool try_lock_shared() { return true; }
+    void unlock_shared() {}
+};
+
+// std::mutex: 读操作与写操作互斥
+struct EXCacheMutexLock
+{
+    static constexpr bool isThreadSafe = true;
+
+    void lock() { m_mutex.lock(); }
+    void unlock() { m_mutex.unlock(); }
+    bool try_lock() { return m_mutex.try_lock(); }
+    void lock_shared() { m_mutex.lock(); }
+    bool try_lock_shared() { return m_mutex.try_lock(); }
+    void unlock_shared() { m_mutex.unlock(); }
+
+private:
+    std::mutex m_mutex;
+};
+
+// std::shared_mutex: count/totalCost/contains 等只读操作可以并行
+struct EXCacheSharedMutexLock
+{
+    static constexpr bool isThreadSafe = true;
+
+    void lock() { m_mutex.lock(); }
+    void unlock() { m_mutex.unlock(); }
+    bool try_lock() { return m_mutex.try_lock(); }
+    void lock_shared() { m_mutex.lock_shared(); }
+    bool try_lock_shared() { return m_mutex.try_lock_shared(); }
+    void unlock_shared() { m_mutex.unlock_shared(); }
+
+private:
+    std::shared_mutex m_mutex;
+};
+
+// 自旋锁: 临界区极短(如 get/put)且线程数不超过 CPU 核数时，比 std::mutex 少一次系统调用
+struct EXCacheSpinLock
+{
+    static constexpr bool isThreadSafe = true;
+
+    void lock()
+    {
+        for (int spins = 0; !try_lock(); ++spins) {
+            // 先只读等待锁释放，减少缓存行争用；自旋过久时让出 CPU
+            while (m_locked.load(std::memory_order_relaxed)) {
+                if (++spins > 64) {
+                    std::this_thread::yield();
+                    spins = 0;
+                }
+            }
+        }
+    }
+
+    void unlock() { m_locked.store(false, std::memory_order_release); }
+    bool try_lock() { return !m_locked.exchange(true, std::memory_order_acquire); }
+    void lock_shared() { lock(); }
+    bool try_lock_shared() { return try_lock(); }
+    void unlock_shared() { unlock(); }
+
+private:
+    std::atomic<bool> m_locked{ false };
+};
@@ -0,0 +1,112 @@
+//
+//  EXCacheStats.h
+//
+//  Created by evanxlh on 2025/7/6.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ EXMemoryCache 的统计快照，由 `stats()` 返回，可以直接相加(分片缓存按分片汇总)。
+ */
+struct EXCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;               // 包括查找时发现已过期的缓存项
+    uint64_t insertions = 0;
+    uint64_t evictions = 0;            // 超出 cost/count 限制被淘汰
+    uint64_t expirations = 0;          // TTL 到期被清除
+    uint64_t replacements = 0;         // 被同一个 key 的 put 替换
+    uint64_t explicitRemovals = 0;     // remove()/clear()
+    uint64_t evictedCost = 0;          // 被淘汰缓存项的 cost 之和(cost 为字节数时即淘汰的字节数)
+
+    uint64_t lockAcquisitions = 0;     // 加锁次数
+    uint64_t sampledLockAcquisitions = 0;    // 其中计时采样的次数
+    uint64_t sampledLockWaitNanoseconds = 0; // 采样的加锁等待总时长
+
+    size_t count = 0;
+    size_t totalCost = 0;
+
+    double hitRatio() const
+    {
+        const uint64_t lookups = hits + misses;
+        return lookups > 0 ? double(hits) / double(lookups) : 0.0;
+    }
+
+    // 平均每次加锁的等待时长(纳秒)，由采样估计
+    double averageLockWaitNanoseconds() const
+    {
+        return sampledLockAcquisitions > 0 ? double(sampledLockWaitNanoseconds) / double(sampledLockAcquisitions) : 0.0;
+    }
+
+    EXCacheStats& operator+=(const EXCacheStats& other)
+    {
+        hits += other.hits;
+        misses += other.misses;
+        insertions += other.insertions;
+        evictions += other.evictions;
+        expirations += other.expirations;
+        replacements += other.replacements;
+        explicitRemovals += other.explicitRemovals;
+        evictedCost += other.evictedCost;
+        lockAcquisitions += other.lockAcquisitions;
+        sampledLockAcquisitions += other.sampledLockAcquisitions;
+        sampledLockWaitNanoseconds += other.sampledLockWaitNanoseconds;
+        count += other.count;
+        totalCost += other.totalCost;
+        return *this;
+    }
+};
+
+/**
+ 统计计数器: 每个缓存(分片)各有一份，独占缓存行。
+
+ 计数器只在持有缓存锁时修改，所以用 relaxed 的 load + store 代替原子的 fetch_add，
+ 不会产生额外的总线锁；`snapshot()` 不加锁，各计数器之间不保证是同一时刻的值。
+ */
+struct alignas(64) EXCacheStatsCounters
+{
+    std::atomic<uint64_t> hits{ 0 };
+    std::atomic<uint64_t> misses{ 0 };
+    std::atomic<uint64_t> insertions{ 0 };
+    std::atomic<uint64_t> evictions{ 0 };
+    std::atomic<uint64_t> expirations{ 0 };
+    std::atomic<uint64_t> replacements{ 0 };
+    std::atomic<uint64_t> explicitRemovals{ 0 };
+    std::atomic<uint64_t> evictedCost{ 0 };
+    std::atomic<uint64_t> lockAcquisitions{ 0 };
+    std::atomic<uint64_t> sampledLockAcquisitions{ 0 };
+    std::atomic<uint64_t> sampledLockWaitNanoseconds{ 0 };
+    std::atomic<size_t> count{ 0 };
+    std::atomic<size_t> totalCost{ 0 };
+
+    // 只能在持有缓存锁时调用
+    template <typename T>
+    static void add(std::atomic<T>& counter, typename std::atomic<T>::value_type value = 1)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    EXCacheStats snapshot() const
+    {
+        EXCacheStats stats;
+        stats.hits = hits.load(std::memory_order_relaxed);
+        stats.misses = misses.load(std::memory_order_relaxed);
+        stats.insertions = insertions.load(std::memory_order_relaxed);
+        stats.evictions = evictions.load(std::memory_order_relaxed);
+        stats.expirations = expirations.load(std::memory_order_relaxed);
+        stats.replacements = replacements.load(std::memory_order_relaxed);
+        stats.explicitRemovals = explicitRemovals.load(std::memory_order_relaxed);
+        stats.evictedCost = evictedCost.load(std::memory_order_relaxed);
+        stats.lockAcquisitions = lockAcquisitions.load(std::memory_order_relaxed);
+        stats.sampledLockAcquisitions = sampledLockAcquisitions.load(std::memory_order_relaxed);
+        stats.sampledLockWaitNanoseconds = sampledLockWaitNanoseconds.load(std::memory_order_relaxed);
+        stats.count = count.load(std::memory_order_relaxed);
+        stats.totalCost = totalCost.load(std::memory_order_relaxed);
+        return stats;
+    }
+};
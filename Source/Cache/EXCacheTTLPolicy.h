@@ -0,0 +1,49 @@
+//
+//  EXCacheTTLPolicy.h
+//
+//  Created by evanxlh on 2025/7/6.
+//
+
+#pragma once
+
+#include "EXTimingWheel.h"
+
+#include <chrono>
+
+/**
+ EXMemoryCache 的存活时间(Time To Live)策略(编译期选择)。
+
+ `NodeFields` 会成为缓存节点的基类: 不开启 TTL 时为空类型，节点不会为过期时间付出任何字节。
+ */
+struct EXCacheNoTTL
+{
+    static constexpr bool hasExpiration = false;
+    static constexpr bool usesWheel = false;
+
+    struct NodeFields {};
+};
+
+// 惰性过期: 只在 get/contains 时检查过期时间，过期项等到被读取或被淘汰时才释放
+struct EXCacheLazyTTL
+{
+    static constexpr bool hasExpiration = true;
+    static constexpr bool usesWheel = false;
+
+    struct NodeFields
+    {
+        std::chrono::steady_clock::time_point expiration;
+    };
+};
+
+// 时间轮过期: 缓存项登记到分层时间轮中，由后台清理线程或 `purgeExpired()` 主动清除
+struct EXCacheWheelTTL
+{
+    static constexpr bool hasExpiration = true;
+    static constexpr bool usesWheel = true;
+
+    struct NodeFields
+    {
+        std::chrono::steady_clock::time_point expiration;
+        EXTimingWheelLinks wheel;
+    };
+};
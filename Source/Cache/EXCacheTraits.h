@@ -0,0 +1,263 @@
+//
+//  EXCacheTraits.h
+//
+//  Created by evanxlh on 2025/7/6.
+//
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#ifdef QT_CORE_LIB
+#include <QString>
+#include <QStringView>
+#include <QHash>
+#include <QByteArray>
+#endif
+
+#ifdef QT_GUI_LIB
+#include <QImage>
+#include <QPixmap>
+#endif
+
+/**
+ 缓存 key 的哈希与比较规则(可特化的定制点)。
+
+ 除了 `Key` 本身，`hash`/`equal` 还可以接受与 `Key` "等价"的查找类型，例如 `std::string` 的
+ `std::string_view`、`QString` 的 `QStringView`。同一内容的查找类型与 `Key` 必须得到相同的哈希值，
+ 这样 get/remove/contains 就可以直接用查找类型探测缓存，不用为每次查找构造临时的 `Key` 对象。
+ */
+template <typename Key>
+struct EXCacheKeyTraits
+{
+    template <typename K>
+    static size_t hash(const K& key) { return std::hash<Key>{}(key); }
+
+    template <typename K>
+    static bool equal(const Key& stored, const K& key) { return stored == key; }
+};
+
+template <>
+struct EXCacheKeyTraits<std::string>
+{
+    // 标准保证 std::hash<std::string> 与 std::hash<std::string_view> 对相同内容给出相同结果
+    static size_t hash(std::string_view key) { return std::hash<std::string_view>{}(key); }
+    static bool equal(const std::string& stored, std::string_view key) { return stored == key; }
+};
+
+#ifdef QT_CORE_LIB
+template <>
+struct EXCacheKeyTraits<QString>
+{
+    // qHash(QString) 与 qHash(QStringView) 对相同内容给出相同结果
+    static size_t hash(QStringView key) { return static_cast<size_t>(qHash(key)); }
+    static bool equal(const QString& stored, QStringView key) { return QStringView(stored) == key; }
+};
+#endif
+
+/**
+ 携带预先计算好的哈希值的查找 key: 同一个 key 需要多次查找(或在多个缓存中查找)时，
+ 只需计算一次哈希。`hash` 必须等于 `EXCacheKeyTraits<Key>::hash(key)`。
+ */
+template <typename K>
+struct EXCacheHashedKey
+{
+    K key;
+    size_t hash;
+};
+
+/**
+ 缓存项 cost 的计算规则(可特化的定制点): put 没有显式指定 cost 时，用 `EXCacheCostOf<Value>::cost(value)`
+ 计算缓存项占用的内存字节数，使 `costLimit` 真正限制缓存占用的内存。
+
+ 未特化的类型 cost 为 1，此时 `costLimit` 等价于数量限制；隐式共享的类型(QPixmap、QByteArray 等)
+ 按完整数据计算，即使数据同时被缓存外部引用。
+ */
+template <typename Value>
+struct EXCacheCostOf
+{
+    static size_t cost(const Value&) { return 1; }
+};
+
+template <>
+struct EXCacheCostOf<std::string>
+{
+    static size_t cost(const std::string& value) { return sizeof(std::string) + value.capacity(); }
+};
+
+// 智能指针按指向的对象计算
+template <typename T>
+struct EXCacheCostOf<std::shared_ptr<T>>
+{
+    static size_t cost(const std::shared_ptr<T>& value) { return value ? EXCacheCostOf<T>::cost(*value) : 1; }
+};
+
+#ifdef QT_CORE_LIB
+template <>
+struct EXCacheCostOf<QByteArray>
+{
+    static size_t cost(const QByteArray& value) { return sizeof(QByteArray) + static_cast<size_t>(value.capacity()); }
+};
+#endif
+
+#ifdef QT_GUI_LIB
+template <>
+struct EXCacheCostOf<QImage>
+{
+    static size_t cost(const QImage& value) { return sizeof(QImage) + static_cast<size_t>(value.sizeInBytes()); }
+};
+
+// QPixmap 的像素数据在平台相关的后端中，按 宽 x 高 x 位深 估算
+template <>
+struct EXCacheCostOf<QPixmap>
+{
+    static size_t cost(const QPixmap& value)
+    {
+        const qint64 bytes = qint64(value.width()) * value.height() * value.depth() / 8;
+        return sizeof(QPixmap) + static_cast<size_t>(bytes);
+    }
+};
+#endif
+
+/**
+ 缓存 key/value 的序列化规则(可特化的定制点)，用于 EXMemoryCacheSnapshot 把缓存写入快照文件:
+   - `serialize(value, out)`: 把 value 的字节追加到 `out`
+   - `deserialize(bytes)`: 从快照中的字节还原 value，数据无效时返回 std::nullopt
+
+ `bytes` 直接指向内存映射的快照文件，起始地址按 16 字节对齐，可以原地读取、无需先拷贝。
+ 快照只在本机重启之间使用，按本机字节序保存。没有特化的类型不能写入快照。
+ */
+template <typename T, typename = void>
+struct EXCacheSerializer;
+
+template <typename T>
+struct EXCacheSerializer<T, std::enable_if_t<std::is_trivially_copyable_v<T>>>
+{
+    static void serialize(const T& value, std::string& out)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    static std::optional<T> deserialize(std::string_view bytes)
+    {
+        if (bytes.size() != sizeof(T)) return std::nullopt;
+        T value;
+        std::memcpy(&value, bytes.data(), sizeof(T));
+        return value;
+    }
+};
+
+template <>
+struct EXCacheSerializer<std::string>
+{
+    static void serialize(const std::string& value, std::string& out) { out += value; }
+    static std::optional<std::string> deserialize(std::string_view bytes) { return std::string(bytes); }
+};
+
+#ifdef QT_CORE_LIB
+// UTF-16 原始数据
+template <>
+struct EXCacheSerializer<QString>
+{
+    static void serialize(const QString& value, std::string& out)
+    {
+        out.append(reinterpret_cast<const char*>(value.constData()), static_cast<size_t>(value.size()) * sizeof(QChar));
+    }
+
+    static std::optional<QString> deserialize(std::string_view bytes)
+    {
+        if (bytes.size() % sizeof(QChar) != 0) return std::nullopt;
+        return QString(reinterpret_cast<const QChar*>(bytes.data()), static_cast<qsizetype>(bytes.size() / sizeof(QChar)));
+    }
+};
+
+template <>
+struct EXCacheSerializer<QByteArray>
+{
+    static void serialize(const QByteArray& value, std::string& out)
+    {
+        out.append(value.constData(), static_cast<size_t>(value.size()));
+    }
+
+    static std::optional<QByteArray> deserialize(std::string_view bytes)
+    {
+        return QByteArray(bytes.data(), static_cast<qsizetype>(bytes.size()));
+    }
+};
+#endif
+
+#ifdef QT_GUI_LIB
+/**
+ QImage 保存未压缩的像素数据(16 字节头 + 扫描线)，读取时不需要解码图片格式。
+ `wrap()` 返回直接引用 `bytes` 的 QImage，供只需要临时读取的场景(如转换为 QPixmap)避免一次拷贝。
+ */
+template <>
+struct EXCacheSerializer<QImage>
+{
+    struct Header
+    {
+        int32_t width;
+        int32_t height;
+        int32_t bytesPerLine;
+        int32_t format;
+    };
+
+    static void serialize(const QImage& value, std::string& out)
+    {
+        const Header header{ value.width(), value.height(), static_cast<int32_t>(value.bytesPerLine()),
+                             static_cast<int32_t>(value.format()) };
+        out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.append(reinterpret_cast<const char*>(value.constBits()), static_cast<size_t>(value.sizeInBytes()));
+    }
+
+    static QImage wrap(std::string_view bytes)
+    {
+        if (bytes.size() < sizeof(Header)) return QImage();
+
+        Header header;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (header.width <= 0 || header.height <= 0 || header.bytesPerLine <= 0
+            || header.format <= QImage::Format_Invalid || header.format >= QImage::NImageFormats
+            || bytes.size() - sizeof(Header) < size_t(header.bytesPerLine) * size_t(header.height)) {
+            return QImage();
+        }
+
+        return QImage(reinterpret_cast<const uchar*>(bytes.data() + sizeof(Header)), header.width, header.height,
+                      header.bytesPerLine, static_cast<QImage::Format>(header.format));
+    }
+
+    static std::optional<QImage> deserialize(std::string_view bytes)
+    {
+        const QImage image = wrap(bytes);
+        if (image.isNull()) return std::nullopt;
+        return image.copy();
+    }
+};
+
+// 按 QImage 保存；读取时拷贝一次像素数据再生成 QPixmap
+template <>
+struct EXCacheSerializer<QPixmap>
+{
+    static void serialize(const QPixmap& value, std::string& out)
+    {
+        EXCacheSerializer<QImage>::serialize(value.toImage(), out);
+    }
+
+    static std::optional<QPixmap> deserialize(std::string_view bytes)
+    {
+        // 格式相同时 QPixmap::fromImage() 会直接共用 QImage 的缓冲区；快照的映射在取完或 close() 时解除，
+        // 不能让缓存中的 QPixmap 指向映射，先拷贝到自己的内存中，再移交给 QPixmap
+        QImage image = EXCacheSerializer<QImage>::wrap(bytes).copy();
+        if (image.isNull()) return std::nullopt;
+        return QPixmap::fromImage(std::move(image));
+    }
+};
+#endif
@@ -6,24 +6,73 @@
 
 #pragma once
 
-#include <list>
-#include <unordered_map>
+#include "EXCacheTraits.h"
+#include "EXTimingWheel.h"
+#include "EXCacheEvictionPolicy.h"
+#include "EXCacheLockPolicy.h"
+#include "EXCacheTTLPolicy.h"
+#include "EXCacheStats.h"
+
+#include <vector>
 #include <mutex>
 #include <optional>
 #include <chrono>
 #include <memory>
 #include <utility>
+#include <new>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <condition_variable>
+#include <shared_mutex>
+#include <type_traits>
+#include <tuple>
+
+// 缓存项被移出缓存的原因
+enum class EXCacheRemovalCause
+{
+    Capacity,   // 超出 cost/count 限制被淘汰
+    Expired,    // TTL 到期
+    Replaced,   // 被同一个 key 的 put 替换
+    Explicit    // remove()/clear()
+};
 
 /**
 高效的 LRU 内存缓存: LRU（Least Recently Used）是一种常见的缓存淘汰策略。
 当缓存满了，需要为新的数据项腾出空间时，LRU策略会选择最近最少使用的数据项进行淘汰。
 
- 1. 使用std::list来存储缓存项的顺序，因为会频繁地在链表的头部和尾部插入和删除元素。
- 2. 使用std::unordered_map来存储键到链表迭代器的映射，可以在O(1)时间内找到任何给定键的元素，避免了链表的O(n)访问时间。
+ 1. 缓存项存放在按块(chunk)分配的节点池中，节点地址固定；释放的节点进入空闲链表，供后续插入复用。
+ 2. LRU 双向链表的前后指针直接内嵌在节点里(以节点下标表示)，不再为每个缓存项单独分配链表节点。
+    淘汰顺序由 `EvictionPolicy` 维护，默认为 LRU，也可以使用 W-TinyLFU(EXCacheTinyLFUPolicy)等策略。
+ 3. 使用开放寻址(线性探测)哈希表保存 key 的哈希标签与节点下标，可以在O(1)时间内找到任何给定键的元素。
+
+ 稳定状态下(节点池与哈希表都已扩容到位) get/put 不会产生任何堆内存分配。
+
+ 线程安全、TTL 与淘汰策略都是编译期的策略参数，未启用的功能既没有运行时分支，也不占用节点字节:
+   - LockPolicy: EXCacheMutexLock(默认)、EXCacheSharedMutexLock、EXCacheSpinLock、EXCacheNoLock
+   - TTLPolicy: EXCacheNoTTL(默认)、EXCacheLazyTTL、EXCacheWheelTTL
+   - EvictionPolicy: EXCacheLRUPolicy(默认)、EXCacheTinyLFUPolicy
+
+ 使用 EXCacheWheelTTL 时，带 TTL 的缓存项会登记到分层时间轮(EXTimingWheel)中，
+ 过期项可以由后台清理线程或 `purgeExpired(budget)` 以均摊 O(1) 的代价主动清除，不必等到被读取或被 LRU 淘汰。
+
+ get/remove/contains 支持异构查找: 可以传入 `EXCacheKeyTraits<Key>` 支持的查找类型
+ (如 `std::string_view`、`QStringView`)或 `EXCacheHashedKey`，不会构造临时的 `Key`。
+
+ `pin()` 返回的 Handle 与 `visit()` 可以直接读取缓存中的 value，不拷贝。被 Handle 持有的缓存项
+ 仍然可以被淘汰、替换或删除(之后的查找不再命中)，但节点要等最后一个 Handle 释放后才会析构。
+
+ `setRemovalListener()` 可以接收被移出缓存的 key/value(例如降级写入磁盘等二级缓存)，见 RemovalListener。
+
+ `stats()`、`count()`、`totalCost()` 不加锁，读取的是持锁操作结束时发布的计数器(见 EXCacheStatsCounters)。
 
  @note Value 支持`值类型`与`智能指针`类型.
  */
-template <typename Key, typename Value>
+template <typename Key,
+          typename Value,
+          typename LockPolicy = EXCacheMutexLock,
+          typename TTLPolicy = EXCacheNoTTL,
+          typename EvictionPolicy = EXCacheLRUPolicy>
 class EXMemoryCache
 {
 public:
@@ -36,190 +85,975 @@ public:
         size_t countLimit = 0;
 
         // 默认 TTL 为 3600 秒: 存活时间到了，缓存项会被标记为已过期，然后从缓存中清除。
-        // 如果 `enablesTTL = true`, 又没有指定有效的 TTL, 就会用到 `defaultTTL`
+        // TTLPolicy 不是 EXCacheNoTTL, 又没有指定有效的 TTL, 就会用到 `defaultTTL`
         size_t defaultTTL{ 3600 };
 
-        // 是否开启缓存项的存活时间(Time To Live): 默认不开启
-        bool enablesTTL = false;
+        // 后台清理线程的唤醒间隔(毫秒)，0 表示不启动后台线程，只通过 `purgeExpired()` 清理。
+        // 只对 EXCacheWheelTTL 且线程安全的 LockPolicy 有效
+        size_t expirySweepInterval = 0;
+
+        // setLimits() 缩小限制时每次持锁最多淘汰的缓存项数量(0: 不限制，一次淘汰到位)
+        size_t trimBatchSize = 256;
+    };
+
+    // 被移出缓存的缓存项，key/value 的所有权交给监听者
+    struct Removal
+    {
+        Key key;
+        Value value;
+        EXCacheRemovalCause cause;
+    };
+
+    /**
+     移除监听: 一次操作(一次 put 的淘汰、一次 purgeExpired、一次 clear 等)移出的缓存项合并为一批，
+     在释放缓存锁之后调用，监听者可以从 `removals` 中移走 key/value，也可以再访问本缓存。
+     被 Handle 钉住的缓存项会拷贝一份交给监听者；Key/Value 不可拷贝时这类缓存项不会通知。
+     */
+    using RemovalListener = std::function<void(std::vector<Removal>& removals)>;
+
+    explicit EXMemoryCache(Config config = {})
+        : m_config(config)
+    {
+        m_policy.setCapacity(m_config.costLimit > 0 ? m_config.costLimit : m_config.countLimit);
+        if constexpr (TTLPolicy::usesWheel && LockPolicy::isThreadSafe) {
+            if (m_config.expirySweepInterval > 0) {
+                _startSweeper();
+            }
+        }
+    }
+
+    /**
+     缓存项的只读引用: 持有期间缓存项被"钉住"，淘汰、替换、删除或 clear() 都不会析构它。
+     Handle 只能移动，析构或 reset() 时解除钉住；不能比所属的缓存活得更久。
+     */
+    class Handle
+    {
+    public:
+        Handle() = default;
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+
+        Handle(Handle&& other) noexcept
+            : m_cache(std::exchange(other.m_cache, nullptr))
+            , m_index(other.m_index)
+            , m_value(std::exchange(other.m_value, nullptr)) {}
+
+        Handle& operator=(Handle&& other) noexcept
+        {
+            if (this != &other) {
+                reset();
+                m_cache = std::exchange(other.m_cache, nullptr);
+                m_index = other.m_index;
+                m_value = std::exchange(other.m_value, nullptr);
+            }
+            return *this;
+        }
+
+        ~Handle() { reset(); }
+
+        explicit operator bool() const { return m_value != nullptr; }
+        const Value& operator*() const { return *m_value; }
+        const Value* operator->() const { return m_value; }
+        const Value* get() const { return m_value; }
+
+        void reset()
+        {
+            if (m_cache == nullptr) return;
+
+            auto lock = m_cache->_lockExclusive();
+            m_cache->_unpin(m_index);
+            m_cache->_publishSizes();
+            m_cache = nullptr;
+            m_value = nullptr;
+        }
+
+    private:
+        friend class EXMemoryCache;
+
+        Handle(EXMemoryCache* cache, uint32_t index, const Value* value)
+            : m_cache(cache), m_index(index), m_value(value) {}
 
-        // 是否开启线程安全: 默认开启
-        bool enablesThreadSafe = true;
+        EXMemoryCache* m_cache = nullptr;
+        uint32_t m_index = 0;
+        const Value* m_value = nullptr;
     };
 
-    explicit EXMemoryCache(Config config = {}) : m_config(config) {}
-    ~EXMemoryCache() { clear(); }
+    ~EXMemoryCache()
+    {
+        _stopSweeper();
+        m_removalListener = nullptr;
+        clear();
+
+        // 正常情况下此时不应再有 Handle 存活，这里只保证节点中的 key/value 被析构
+        m_detached.forEach(*this, [this](NodeIndex index) {
+            _node(index).key().~Key();
+            _node(index).value().~Value();
+        });
+    }
+
+    template <typename K = Key>
+    std::optional<Value> get(const K& key)
+    {
+        auto lock = _lockExclusive();
+        std::optional<Value> value = _get(key);
+        _finishOperation(lock);
+        return value;
+    }
+
+    // 查找并钉住缓存项，不拷贝 value；未命中时返回空的 Handle
+    template <typename K = Key>
+    Handle pin(const K& key)
+    {
+        auto lock = _lockExclusive();
+        const NodeIndex index = _access(key);
+        if (index == InvalidIndex) {
+            _finishOperation(lock);
+            return Handle();
+        }
 
-    std::optional<Value> get(const Key& key)
+        Node& node = _node(index);
+        ++node.pins;
+        return Handle(this, index, &node.value());
+    }
+
+    /**
+     命中时在持锁状态下以 `const Value&` 调用 `fn`，不拷贝 value；返回是否命中。
+     `fn` 中不能再访问本缓存，耗时的操作请改用 pin()。
+     */
+    template <typename K = Key, typename Fn>
+    bool visit(const K& key, Fn&& fn)
     {
-        if (m_config.enablesThreadSafe) {
-            std::unique_lock lock(m_mutex);
-            return _get(key);
+        auto lock = _lockExclusive();
+        const NodeIndex index = _access(key);
+        if (index == InvalidIndex) {
+            _finishOperation(lock);
+            return false;
         }
 
-        return _get(key);
+        std::forward<Fn>(fn)(static_cast<const Value&>(_node(index).value()));
+        return true;
     }
 
+    // put 的 cost 参数为 AutoCost 时，由 EXCacheCostOf<Value> 根据 value 计算
+    static constexpr size_t AutoCost = SIZE_MAX;
+
     // 插入缓存项（完美转发）
     template <typename K, typename V>
-    void put(K&& key, V&& value, size_t cost = 1, int ttl = 0)
+    void put(K&& key, V&& value, size_t cost = AutoCost, int ttl = 0)
     {
-        auto newItem = std::make_shared<CacheItem>();
-        newItem->key = std::forward<K>(key);
-        newItem->value = std::forward<V>(value);
-        newItem->cost = cost;
+        const TimePoint expiration = _expiration(ttl);
 
-        if (m_config.enablesTTL) {
-            const auto now = Clock::now();
-            if (ttl > 0) {
-                newItem->expiration = now + std::chrono::seconds(ttl);
-            } else if (m_config.defaultTTL > 0) {
-                newItem->expiration = now + std::chrono::seconds(m_config.defaultTTL);
-            }
+        auto lock = _lockExclusive();
+        _put(std::forward<K>(key), std::forward<V>(value), cost, expiration);
+        _finishOperation(lock);
+    }
+
+    template <typename K = Key>
+    bool remove(const K& key)
+    {
+        auto lock = _lockExclusive();
+        const bool removed = _remove(key);
+        _finishOperation(lock);
+        return removed;
+    }
+
+    // 是否存在未过期的缓存项: 不拷贝 value，也不改变 LRU 顺序(只读，持共享锁)
+    template <typename K = Key>
+    bool contains(const K& key) const
+    {
+        auto lock = _lockShared();
+        return _contains(key);
+    }
+
+    /**
+     批量查找: 对 `keys` 中的每个 key 依次向 `out` 写入一个 `std::optional<Value>`，整批只加一次锁。
+     key 可以是 get() 支持的任意查找类型，也可以是它们的 std::reference_wrapper。
+     */
+    template <typename KeyRange, typename OutputIt>
+    OutputIt getMany(const KeyRange& keys, OutputIt out)
+    {
+        auto lock = _lockExclusive();
+        for (const auto& key : keys) {
+            *out = _get(key);
+            ++out;
         }
+        _finishOperation(lock);
+        return out;
+    }
 
-        if (m_config.enablesThreadSafe) {
-            std::unique_lock lock(m_mutex);
-            _put(std::move(newItem));
-        } else {
-            _put(std::move(newItem));
+    /**
+     批量插入: `entries` 的元素为 (key, value) 或 (key, value, cost) 的 tuple-like 对象
+     (也可以是它们的 std::reference_wrapper)，没有 cost 时按 AutoCost 计算。整批只加一次锁，全部插入后才统一淘汰一次。
+     传入右值区间时 key/value 会被移动进缓存。
+     */
+    template <typename EntryRange>
+    void putMany(EntryRange&& entries, int ttl = 0)
+    {
+        constexpr bool movesEntries = !std::is_lvalue_reference_v<EntryRange>;
+        const TimePoint expiration = _expiration(ttl);
+
+        auto lock = _lockExclusive();
+        for (auto& entry : entries) {
+            _insertEntry<movesEntries>(entry, expiration);
         }
+        _trim();
+        _finishOperation(lock);
     }
 
-    bool remove(const Key& key)
+    // 批量删除，整批只加一次锁，返回实际删除的数量
+    template <typename KeyRange>
+    size_t removeMany(const KeyRange& keys)
     {
-        if (m_config.enablesThreadSafe) {
-            std::unique_lock lock(m_mutex);
-            return _remove(key);
+        size_t removed = 0;
+        auto lock = _lockExclusive();
+        for (const auto& key : keys) {
+            removed += _remove(key) ? 1 : 0;
         }
+        _finishOperation(lock);
+        return removed;
+    }
 
-        return _remove(key);
+    /**
+     按淘汰顺序(最先被淘汰的在前，最近使用的在最后)遍历缓存项，以 `fn(key, value)` 调用，持共享锁。
+     不改变 LRU 顺序，也不检查 TTL；`fn` 中不能再访问本缓存。
+     */
+    template <typename Fn>
+    void forEach(Fn&& fn)
+    {
+        auto lock = _lockShared();
+        m_policy.forEach(*this, [this, &fn](NodeIndex index) {
+            Node& node = _node(index);
+            fn(static_cast<const Key&>(node.key()), static_cast<const Value&>(node.value()));
+        });
     }
 
     // 清空缓存
     void clear()
     {
-        if (m_config.enablesThreadSafe) {
-            std::unique_lock lock(m_mutex);
-            _clear();
+        auto lock = _lockExclusive();
+        _clear();
+        _finishOperation(lock);
+    }
+
+    /**
+     运行时修改 cost/count 限制(0: 无限制)。
+     缩小限制时分批淘汰: 每批最多 `Config::trimBatchSize` 项，批次之间释放锁，
+     让其他线程的 get/put 可以穿插执行(期间它们的淘汰同样按批进行)。返回时缓存已满足新的限制。
+     */
+    void setLimits(size_t costLimit, size_t countLimit)
+    {
+        auto lock = _lockExclusive();
+        m_config.costLimit = costLimit;
+        m_config.countLimit = countLimit;
+        m_policy.setCapacity(costLimit > 0 ? costLimit : countLimit);
+
+        ++m_pendingShrinks;
+        while (_trim(m_config.trimBatchSize) > 0 && _shouldTrim()) {
+            _finishOperation(lock);
+            if (lock.owns_lock()) lock.unlock();
+            std::this_thread::yield();
+            lock.lock();
+        }
+        --m_pendingShrinks;
+        _finishOperation(lock);
+    }
+
+    // 设置移除监听(传入空函数表示取消)，之后移出的缓存项才会通知
+    void setRemovalListener(RemovalListener listener)
+    {
+        auto lock = _lockExclusive();
+        m_removalListener = listener ? std::make_shared<const RemovalListener>(std::move(listener)) : nullptr;
+    }
+
+    /**
+     增量清理已过期的缓存项(需要 EXCacheWheelTTL)。
+     `budget` 为本次最多清理的缓存项数量(0: 不限制)，返回实际清理的数量。
+     */
+    size_t purgeExpired(size_t budget = 0)
+    {
+        if constexpr (TTLPolicy::usesWheel) {
+            auto lock = _lockExclusive();
+            const size_t purged = _purgeExpired(Clock::now(), budget);
+            _finishOperation(lock);
+            return purged;
         } else {
-            _clear();
+            (void)budget;
+            return 0;
         }
     }
 
-    // 缓存占用的内存字节数
+    // 缓存占用的内存字节数(包括已被移除、但仍被 Handle 钉住的缓存项)，不加锁
     size_t totalCost() const
     {
-        if (m_config.enablesThreadSafe) {
-            std::unique_lock lock(m_mutex);
-            return m_totalCost;
-        }
-        return m_totalCost;
+        return m_stats.totalCost.load(std::memory_order_relaxed);
     }
 
-    // 缓存项数量
+    // 缓存项数量，不加锁
     size_t count() const
     {
-        if (m_config.enablesThreadSafe) {
-            std::unique_lock lock(m_mutex);
-            return m_cacheMap.size();
-        }
-        return m_cacheMap.size();
+        return m_stats.count.load(std::memory_order_relaxed);
+    }
+
+    // 统计快照，不加锁
+    EXCacheStats stats() const
+    {
+        return m_stats.snapshot();
+    }
+
+    // 单个缓存项在节点池中占用的字节数(不含 key/value 自身在堆上分配的内存与哈希表槽位)
+    static constexpr size_t entrySize() { return sizeof(Node); }
+
+    // 计算查找 key 的哈希值，可与 EXCacheHashedKey 配合复用
+    template <typename K>
+    static size_t hashKey(const K& key) { return KeyTraits::hash(key); }
+
+    template <typename K>
+    static size_t hashKey(const EXCacheHashedKey<K>& key) { return key.hash; }
+
+    template <typename K>
+    static size_t hashKey(std::reference_wrapper<K> key) { return hashKey(key.get()); }
+
+    template <typename K>
+    static EXCacheHashedKey<K> hashedKey(K key)
+    {
+        const size_t hash = hashKey(key);
+        return { std::move(key), hash };
     }
 
 private:
 
+    using KeyTraits = EXCacheKeyTraits<Key>;
     using Clock = std::chrono::steady_clock;
     using TimePoint = Clock::time_point;
+    using NodeIndex = uint32_t;
+    using Wheel = EXTimingWheel<EXMemoryCache>;
+    using Policy = typename EvictionPolicy::template Engine<EXMemoryCache>;
 
-    struct CacheItem {
-        Key key;
-        Value value;
+    friend Wheel;
+    friend Policy;
+    friend EXCacheNodeList<EXMemoryCache>;
+
+    static constexpr NodeIndex InvalidIndex = UINT32_MAX;
+
+    // 每个块容纳的节点数量(2 的幂)
+    static constexpr NodeIndex ChunkShift = 10;
+    static constexpr NodeIndex ChunkSize = NodeIndex(1) << ChunkShift;
+
+    // 哈希表初始槽位数与最大装载因子(分子/分母)
+    static constexpr size_t InitialSlotCount = 16;
+    static constexpr size_t MaxLoadNumerator = 3;
+    static constexpr size_t MaxLoadDenominator = 4;
+
+    // 时间轮的 tick 精度，以及后台清理线程每次持锁最多清理的缓存项数量
+    static constexpr std::chrono::milliseconds WheelTick{ 250 };
+    static constexpr size_t SweepBatchSize = 256;
+
+    // 加锁等待时长的采样间隔(2 的幂)
+    static constexpr uint32_t LockWaitSampleInterval = 64;
+
+    // Node::pins 的最高位: 节点已从缓存中移除，等待最后一个 Handle 释放
+    static constexpr uint32_t DetachedFlag = 0x80000000u;
+
+    // TTLPolicy::NodeFields 为基类: 不开启 TTL 时是空基类，不占用字节
+    struct Node : TTLPolicy::NodeFields
+    {
+        // key/value 在节点被占用时才构造，释放节点时析构，不要求 Key/Value 可默认构造
+        alignas(Key) unsigned char keyStorage[sizeof(Key)];
+        alignas(Value) unsigned char valueStorage[sizeof(Value)];
         size_t cost;
-        TimePoint lastAccess;
-        TimePoint expiration;
+        size_t weight;             // 插入时的策略权重，移除时按它扣减，setLimits() 切换 cost/count 后仍一致
+        size_t hash;
+        EXCachePolicyLinks links;  // 淘汰策略的链表指针; 空闲节点用 links.next 串成空闲链表
+        uint32_t pins;             // 存活的 Handle 数量(最高位为 DetachedFlag)
+
+        Key& key() { return *std::launder(reinterpret_cast<Key*>(keyStorage)); }
+        Value& value() { return *std::launder(reinterpret_cast<Value*>(valueStorage)); }
+    };
+
+    // 哈希表槽位: 节点下标 + 哈希低 32 位作为标签，标签不匹配时无需访问节点
+    struct Slot
+    {
+        NodeIndex index = InvalidIndex;
+        uint32_t tag = 0;
+    };
+
+    // 时间轮及后台清理线程的状态，只在 EXCacheWheelTTL 时存在
+    struct WheelState
+    {
+        TimePoint origin = Clock::now();  // 时间轮 tick 0 对应的时间点
+        Wheel wheel;
+        std::thread sweeper;
+        std::condition_variable_any sweeperCondition;
+        bool stopsSweeper = false;
     };
 
-    using ItemPtr = std::shared_ptr<CacheItem>;
-    using ItemList = std::list<ItemPtr>;
-    using CacheMap = std::unordered_map<Key, typename ItemList::iterator>;
+    struct NoWheelState {};
+
+    inline Node& _node(NodeIndex index) const
+    {
+        return m_chunks[index >> ChunkShift][index & (ChunkSize - 1)];
+    }
+
+    // 淘汰策略访问节点的接口
+    EXCachePolicyLinks& policyLinks(NodeIndex index) { return _node(index).links; }
+    size_t policyHash(NodeIndex index) { return _node(index).hash; }
 
-    inline bool _isItemExpired(const ItemPtr& item, const TimePoint& now) const
+    // 插入时有 cost 限制则按 cost 计算权重，否则按数量
+    size_t policyWeight(NodeIndex index) { return _node(index).weight; }
+
+    // EXTimingWheel 访问节点的接口
+    EXTimingWheelLinks& wheelLinks(NodeIndex index) { return _node(index).wheel; }
+
+    uint64_t deadlineTick(NodeIndex index)
+    {
+        // 向上取整: 时间轮处理到该 tick 时缓存项一定已经过期
+        const auto elapsed = std::chrono::ceil<std::chrono::milliseconds>(_node(index).expiration - m_expiry.origin);
+        if (elapsed.count() <= 0) return 0;
+        return static_cast<uint64_t>((elapsed.count() + WheelTick.count() - 1) / WheelTick.count());
+    }
+
+    uint64_t _wheelTick(const TimePoint& now) const
     {
-        return item->expiration.time_since_epoch().count() > 0 && now >= item->expiration;
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now - m_expiry.origin) / WheelTick);
     }
 
+    inline bool _isItemExpired(const Node& node, const TimePoint& now) const
+    {
+        return node.expiration.time_since_epoch().count() > 0 && now >= node.expiration;
+    }
+
+    // 被钉住的已移除节点淘汰不掉，不计入淘汰判断
     inline bool _shouldTrim() const
     {
-        if (m_config.costLimit > 0 && m_totalCost > m_config.costLimit) return true;
-        if (m_config.countLimit > 0 && m_cacheMap.size() > m_config.countLimit) return true;
+        if (m_config.costLimit > 0 && m_totalCost - m_detachedCost > m_config.costLimit) return true;
+        if (m_config.countLimit > 0 && m_count > m_config.countLimit) return true;
         return false;
     }
 
-    void _trim()
+    // Fibonacci 哈希: 把哈希值打散到表的高位，避免整数 key 的恒等哈希造成聚集
+    inline size_t _homeSlot(size_t hash) const
+    {
+        return static_cast<size_t>((static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL) >> m_slotShift);
+    }
+
+    template <typename K>
+    static const K& _lookupKey(const K& key) { return key; }
+
+    template <typename K>
+    static const K& _lookupKey(const EXCacheHashedKey<K>& key) { return key.key; }
+
+    template <typename K>
+    static decltype(auto) _lookupKey(std::reference_wrapper<K> key) { return _lookupKey(key.get()); }
+
+    template <typename T>
+    struct IsReferenceWrapper : std::false_type {};
+
+    template <typename T>
+    struct IsReferenceWrapper<std::reference_wrapper<T>> : std::true_type {};
+
+    TimePoint _expiration(int ttl) const
+    {
+        TimePoint expiration;
+        if constexpr (TTLPolicy::hasExpiration) {
+            const auto now = Clock::now();
+            if (ttl > 0) {
+                expiration = now + std::chrono::seconds(ttl);
+            } else if (m_config.defaultTTL > 0) {
+                expiration = now + std::chrono::seconds(m_config.defaultTTL);
+            }
+        } else {
+            (void)ttl;
+        }
+        return expiration;
+    }
+
+    // 查找 key 所在的槽位，未找到返回 m_slots.size()
+    template <typename K>
+    size_t _findSlot(const K& key, size_t hash) const
     {
-        while (!m_itemList.empty() && _shouldTrim()) {
-            auto& item = m_itemList.front();
-            m_totalCost -= item->cost;
-            m_cacheMap.erase(item->key);
-            m_itemList.pop_front();
+        if (m_slots.empty()) return 0;
+
+        const size_t mask = m_slots.size() - 1;
+        const uint32_t tag = static_cast<uint32_t>(hash);
+        for (size_t pos = _homeSlot(hash); ; pos = (pos + 1) & mask) {
+            const Slot& slot = m_slots[pos];
+            if (slot.index == InvalidIndex) return m_slots.size();
+            if (slot.tag == tag && KeyTraits::equal(_node(slot.index).key(), key)) return pos;
+        }
+    }
+
+    void _insertSlot(size_t hash, NodeIndex index)
+    {
+        if (m_slots.empty() || (m_count + 1) * MaxLoadDenominator > m_slots.size() * MaxLoadNumerator) {
+            _rehash(m_slots.empty() ? InitialSlotCount : m_slots.size() * 2);
+        }
+
+        const size_t mask = m_slots.size() - 1;
+        size_t pos = _homeSlot(hash);
+        while (m_slots[pos].index != InvalidIndex) {
+            pos = (pos + 1) & mask;
+        }
+        m_slots[pos].index = index;
+        m_slots[pos].tag = static_cast<uint32_t>(hash);
+    }
+
+    // 线性探测的删除: 把后续同一探测簇中的槽位向前移动，不使用墓碑
+    void _eraseSlot(size_t pos)
+    {
+        const size_t mask = m_slots.size() - 1;
+        size_t hole = pos;
+        for (size_t next = (pos + 1) & mask; m_slots[next].index != InvalidIndex; next = (next + 1) & mask) {
+            const size_t home = _homeSlot(_node(m_slots[next].index).hash);
+            // home 不在 (hole, next] 区间内时，该槽位可以移动到 hole
+            const bool movable = (next > hole) ? (home <= hole || home > next)
+                                               : (home <= hole && home > next);
+            if (movable) {
+                m_slots[hole] = m_slots[next];
+                hole = next;
+            }
+        }
+        m_slots[hole] = Slot();
+    }
+
+    // 查找指向节点 index 的槽位(节点一定在表中)
+    size_t _findSlotOf(NodeIndex index)
+    {
+        const size_t mask = m_slots.size() - 1;
+        size_t pos = _homeSlot(_node(index).hash);
+        while (m_slots[pos].index != index) {
+            pos = (pos + 1) & mask;
+        }
+        return pos;
+    }
+
+    void _rehash(size_t slotCount)
+    {
+        std::vector<Slot> oldSlots(slotCount);
+        oldSlots.swap(m_slots);
+
+        m_slotShift = 64;
+        for (size_t n = slotCount; n > 1; n >>= 1) {
+            --m_slotShift;
+        }
+
+        const size_t mask = m_slots.size() - 1;
+        for (const Slot& slot : oldSlots) {
+            if (slot.index == InvalidIndex) continue;
+            size_t pos = _homeSlot(_node(slot.index).hash);
+            while (m_slots[pos].index != InvalidIndex) {
+                pos = (pos + 1) & mask;
+            }
+            m_slots[pos] = slot;
+        }
+    }
+
+    NodeIndex _allocateNode()
+    {
+        if (m_freeHead != InvalidIndex) {
+            const NodeIndex index = m_freeHead;
+            m_freeHead = _node(index).links.next;
+            return index;
+        }
+
+        if (m_nodeWatermark == m_chunks.size() * ChunkSize) {
+            m_chunks.emplace_back(new Node[ChunkSize]);
+        }
+        return m_nodeWatermark++;
+    }
+
+    void _releaseNode(NodeIndex index)
+    {
+        Node& node = _node(index);
+        node.key().~Key();
+        node.value().~Value();
+        node.links.next = m_freeHead;
+        m_freeHead = index;
+    }
+
+    void _removeAt(size_t slotPos, EXCacheRemovalCause cause)
+    {
+        const NodeIndex index = m_slots[slotPos].index;
+        _eraseSlot(slotPos);
+        m_policy.onRemove(*this, index);
+        if constexpr (TTLPolicy::usesWheel) {
+            m_expiry.wheel.unschedule(*this, index);
+        }
+        --m_count;
+
+        Node& node = _node(index);
+        _countRemoval(node, cause);
+        _reportRemoval(node, cause);
+        if (node.pins > 0) {
+            _detach(index);
+        } else {
+            m_totalCost -= node.cost;
+            _releaseNode(index);
+        }
+    }
+
+    // 被钉住的节点移出缓存后挂到 m_detached(复用淘汰策略的链表指针)，cost 仍计入 m_totalCost
+    void _detach(NodeIndex index)
+    {
+        Node& node = _node(index);
+        node.pins |= DetachedFlag;
+        m_detached.pushBack(*this, index);
+        m_detachedCost += node.cost;
+    }
+
+    void _countRemoval(const Node& node, EXCacheRemovalCause cause)
+    {
+        switch (cause) {
+        case EXCacheRemovalCause::Capacity:
+            EXCacheStatsCounters::add(m_stats.evictions);
+            EXCacheStatsCounters::add(m_stats.evictedCost, node.cost);
+            break;
+        case EXCacheRemovalCause::Expired:
+            EXCacheStatsCounters::add(m_stats.expirations);
+            break;
+        case EXCacheRemovalCause::Replaced:
+            EXCacheStatsCounters::add(m_stats.replacements);
+            break;
+        case EXCacheRemovalCause::Explicit:
+            EXCacheStatsCounters::add(m_stats.explicitRemovals);
+            break;
+        }
+    }
+
+    // 有监听者时把 key/value 移入待通知列表(被钉住的节点只能拷贝)
+    void _reportRemoval(Node& node, EXCacheRemovalCause cause)
+    {
+        if (!m_removalListener) return;
+
+        if (node.pins == 0) {
+            m_pendingRemovals.push_back({ std::move(node.key()), std::move(node.value()), cause });
+        } else if constexpr (std::is_copy_constructible_v<Key> && std::is_copy_constructible_v<Value>) {
+            m_pendingRemovals.push_back({ node.key(), node.value(), cause });
+        }
+    }
+
+    /**
+     加锁并统计等待时长: 每个线程每 LockWaitSampleInterval 次加锁计时一次。
+     每次都读时钟(或先 try_lock 再计时)的开销与一次缓存命中相当，采样后均摊开销可以忽略。
+     */
+    template <typename Lock>
+    Lock _lockSampled() const
+    {
+        if constexpr (!LockPolicy::isThreadSafe) {
+            return Lock(m_lock);
+        } else {
+            thread_local uint32_t acquisitions = 0;
+            if ((++acquisitions & (LockWaitSampleInterval - 1)) != 0) {
+                return Lock(m_lock);
+            }
+
+            const auto start = Clock::now();
+            Lock lock(m_lock);
+            const auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+            m_stats.sampledLockAcquisitions.fetch_add(1, std::memory_order_relaxed);
+            m_stats.sampledLockWaitNanoseconds.fetch_add(static_cast<uint64_t>(wait.count()), std::memory_order_relaxed);
+            return lock;
+        }
+    }
+
+    std::unique_lock<LockPolicy> _lockExclusive() const
+    {
+        auto lock = _lockSampled<std::unique_lock<LockPolicy>>();
+        EXCacheStatsCounters::add(m_stats.lockAcquisitions);
+        return lock;
+    }
+
+    std::shared_lock<LockPolicy> _lockShared() const
+    {
+        auto lock = _lockSampled<std::shared_lock<LockPolicy>>();
+        // 共享锁可能有多个持有者，这里必须用原子加
+        m_stats.lockAcquisitions.fetch_add(1, std::memory_order_relaxed);
+        return lock;
+    }
+
+    // 发布 count/totalCost 的无锁镜像
+    void _publishSizes()
+    {
+        m_stats.count.store(m_count, std::memory_order_relaxed);
+        m_stats.totalCost.store(m_totalCost, std::memory_order_relaxed);
+    }
+
+    // 持锁操作结束: 发布计数器，释放锁之后把本次操作移出的缓存项交给监听者，返回时锁已释放
+    template <typename Lock>
+    void _finishOperation(Lock& lock)
+    {
+        _publishSizes();
+        if (m_pendingRemovals.empty()) return;
+
+        std::vector<Removal> removals;
+        removals.swap(m_pendingRemovals);
+        const auto listener = m_removalListener;
+        lock.unlock();
+
+        if (listener) {
+            (*listener)(removals);
         }
     }
 
-    std::optional<Value> _get(const Key& key)
+    void _unpin(NodeIndex index)
     {
-        auto it = m_cacheMap.find(key);
-        if (it == m_cacheMap.end()) return std::nullopt;
+        Node& node = _node(index);
+        if (--node.pins == DetachedFlag) {
+            m_detached.remove(*this, index);
+            m_detachedCost -= node.cost;
+            m_totalCost -= node.cost;
+            _releaseNode(index);
+        }
+    }
+
+    /**
+     淘汰到满足限制为止，`budget` 为本次最多移除的缓存项数量(0: 不限制)，返回实际移除的数量。
+     setLimits() 正在分批缩小时，其他操作触发的淘汰也按 `trimBatchSize` 分批，避免把整次缩小转嫁给某个 put。
+     */
+    size_t _trim(size_t budget = 0)
+    {
+        if (budget == 0 && m_pendingShrinks > 0) {
+            budget = m_config.trimBatchSize;
+        }
 
-        const auto now = Clock::now();
-        auto& item = *it->second;
-        if (m_config.enablesTTL && _isItemExpired(item, now)) {
-            _remove(key);
-            return std::nullopt;
+        // 先清除已过期的缓存项，仍然超出限制时再按 LRU 淘汰
+        size_t removed = 0;
+        if constexpr (TTLPolicy::usesWheel) {
+            if (_shouldTrim()) {
+                removed = _purgeExpired(Clock::now(), budget);
+            }
         }
 
-        // 更新访问时间并移至LRU尾部
-        item->lastAccess = now;
-        m_itemList.splice(m_itemList.end(), m_itemList, it->second);
+        while (m_count > 0 && _shouldTrim() && (budget == 0 || removed < budget)) {
+            _removeAt(_findSlotOf(m_policy.victim(*this)), EXCacheRemovalCause::Capacity);
+            ++removed;
+        }
+        return removed;
+    }
 
-        return item->value;
+    size_t _purgeExpired(const TimePoint& now, size_t budget)
+    {
+        return m_expiry.wheel.advance(*this, _wheelTick(now), budget, [this](NodeIndex index) {
+            _removeAt(_findSlotOf(index), EXCacheRemovalCause::Expired);
+        });
     }
 
-    void _put(ItemPtr newItem)
+    void _startSweeper()
     {
-        if (auto it = m_cacheMap.find(newItem->key); it != m_cacheMap.end()) {
-            _remove(newItem->key);
+        m_expiry.sweeper = std::thread([this] {
+            const auto interval = std::chrono::milliseconds(m_config.expirySweepInterval);
+            std::unique_lock lock(m_lock);
+            while (!m_expiry.stopsSweeper) {
+                m_expiry.sweeperCondition.wait_for(lock, interval, [this] { return m_expiry.stopsSweeper; });
+
+                // 分批清理，批次之间释放锁，避免长时间阻塞 get/put
+                while (!m_expiry.stopsSweeper) {
+                    const size_t purged = _purgeExpired(Clock::now(), SweepBatchSize);
+                    _finishOperation(lock);
+                    if (purged < SweepBatchSize) break;
+
+                    if (lock.owns_lock()) lock.unlock();
+                    std::this_thread::yield();
+                    lock.lock();
+                }
+                if (!lock.owns_lock()) lock.lock();
+            }
+        });
+    }
+
+    void _stopSweeper()
+    {
+        if constexpr (TTLPolicy::usesWheel) {
+            if (!m_expiry.sweeper.joinable()) return;
+
+            {
+                std::unique_lock lock(m_lock);
+                m_expiry.stopsSweeper = true;
+            }
+            m_expiry.sweeperCondition.notify_all();
+            m_expiry.sweeper.join();
         }
+    }
 
-        // 插入新项到LRU尾部
-        auto listIt = m_itemList.insert(m_itemList.end(), std::move(newItem));
-        auto item = *listIt;
-        m_cacheMap.emplace(item->key, listIt);
-        m_totalCost += item->cost;
+    // 查找并记录一次访问，未命中(或已过期)时返回 InvalidIndex
+    template <typename K>
+    NodeIndex _access(const K& key)
+    {
+        const size_t hash = hashKey(key);
+        const size_t pos = _findSlot(_lookupKey(key), hash);
+        if (pos == m_slots.size()) {
+            m_policy.onMiss(hash);
+            EXCacheStatsCounters::add(m_stats.misses);
+            return InvalidIndex;
+        }
+
+        const NodeIndex index = m_slots[pos].index;
+        if constexpr (TTLPolicy::hasExpiration) {
+            if (_isItemExpired(_node(index), Clock::now())) {
+                _removeAt(pos, EXCacheRemovalCause::Expired);
+                EXCacheStatsCounters::add(m_stats.misses);
+                return InvalidIndex;
+            }
+        }
 
+        m_policy.onAccess(*this, index);
+        EXCacheStatsCounters::add(m_stats.hits);
+        return index;
+    }
+
+    template <typename K>
+    std::optional<Value> _get(const K& key)
+    {
+        const NodeIndex index = _access(key);
+        if (index == InvalidIndex) return std::nullopt;
+
+        return _node(index).value();
+    }
+
+    template <typename K, typename V>
+    void _put(K&& key, V&& value, size_t cost, TimePoint expiration)
+    {
+        _insert(std::forward<K>(key), std::forward<V>(value), cost, expiration);
         _trim();
     }
 
-    bool _remove(const Key& key)
+    // putMany 的单个元素: tuple-like 的 (key, value[, cost])
+    template <bool MovesEntry, typename Entry>
+    void _insertEntry(Entry& entry, const TimePoint& expiration)
     {
-        if (auto it = m_cacheMap.find(key); it != m_cacheMap.end()) {
-            m_totalCost -= (*it->second)->cost;
-            m_itemList.erase(it->second);
-            m_cacheMap.erase(it);
+        if constexpr (IsReferenceWrapper<std::remove_const_t<Entry>>::value) {
+            _insertEntry<false>(entry.get(), expiration);
+        } else {
+            size_t cost = AutoCost;
+            if constexpr (std::tuple_size_v<std::remove_const_t<Entry>> >= 3) {
+                cost = std::get<2>(entry);
+            }
+
+            if constexpr (MovesEntry) {
+                _insert(std::get<0>(std::move(entry)), std::get<1>(std::move(entry)), cost, expiration);
+            } else {
+                _insert(std::get<0>(entry), std::get<1>(entry), cost, expiration);
+            }
+        }
+    }
+
+    // 插入(或替换)缓存项，不做淘汰
+    template <typename K, typename V>
+    void _insert(K&& key, V&& value, size_t cost, TimePoint expiration)
+    {
+        const NodeIndex index = _allocateNode();
+        Node& node = _node(index);
+        new (node.keyStorage) Key(std::forward<K>(key));
+        new (node.valueStorage) Value(std::forward<V>(value));
+        node.cost = cost == AutoCost ? EXCacheCostOf<Value>::cost(node.value()) : cost;
+        node.weight = m_config.costLimit > 0 ? node.cost : 1;
+        node.hash = KeyTraits::hash(node.key());
+        node.pins = 0;
+        if constexpr (TTLPolicy::hasExpiration) {
+            node.expiration = expiration;
+        } else {
+            (void)expiration;
+        }
+        if constexpr (TTLPolicy::usesWheel) {
+            node.wheel.slot = Wheel::NoSlot;
+        }
+
+        if (size_t pos = _findSlot(node.key(), node.hash); pos != m_slots.size()) {
+            _removeAt(pos, EXCacheRemovalCause::Replaced);
+        }
+
+        _insertSlot(node.hash, index);
+        m_policy.onInsert(*this, index);
+        if constexpr (TTLPolicy::usesWheel) {
+            if (expiration.time_since_epoch().count() > 0) {
+                m_expiry.wheel.schedule(*this, index);
+            }
+        }
+        m_totalCost += node.cost;
+        ++m_count;
+        EXCacheStatsCounters::add(m_stats.insertions);
+    }
+
+    template <typename K>
+    bool _remove(const K& key)
+    {
+        if (size_t pos = _findSlot(_lookupKey(key), hashKey(key)); pos != m_slots.size()) {
+            _removeAt(pos, EXCacheRemovalCause::Explicit);
             return true;
         }
         return false;
     }
 
+    template <typename K>
+    bool _contains(const K& key) const
+    {
+        const size_t pos = _findSlot(_lookupKey(key), hashKey(key));
+        if (pos == m_slots.size()) return false;
+
+        if constexpr (TTLPolicy::hasExpiration) {
+            // 只读检查: 过期项留给 get 或时间轮清除
+            return !_isItemExpired(_node(m_slots[pos].index), Clock::now());
+        }
+        return true;
+    }
+
     void _clear() {
-        m_itemList.clear();
-        m_cacheMap.clear();
-        m_totalCost = 0;
+        // 被钉住的节点先移到 m_detached
+        for (const Slot& slot : m_slots) {
+            if (slot.index == InvalidIndex) continue;
+            _countRemoval(_node(slot.index), EXCacheRemovalCause::Explicit);
+            _reportRemoval(_node(slot.index), EXCacheRemovalCause::Explicit);
+            if (_node(slot.index).pins > 0) {
+                _detach(slot.index);
+            }
+        }
+
+        // 没有被钉住的节点时整体释放节点池，否则只逐个回收未被钉住的节点
+        const bool keepsChunks = !m_detached.isEmpty();
+        for (const Slot& slot : m_slots) {
+            if (slot.index == InvalidIndex) continue;
+            Node& node = _node(slot.index);
+            if (node.pins > 0) continue;
+
+            if (keepsChunks) {
+                m_totalCost -= node.cost;
+                _releaseNode(slot.index);
+            } else {
+                node.key().~Key();
+                node.value().~Value();
+            }
+        }
+
+        m_policy.reset();
+        m_slots.clear();
+        m_slotShift = 64;
+        if constexpr (TTLPolicy::usesWheel) {
+            m_expiry.wheel.reset(_wheelTick(Clock::now()));
+        }
+        m_count = 0;
+        if (!keepsChunks) {
+            m_chunks.clear();
+            m_freeHead = InvalidIndex;
+            m_nodeWatermark = 0;
+            m_totalCost = 0;
+        }
     }
 
 private:
     Config m_config;
-    ItemList m_itemList;  // LRU队列（头部最旧，尾部最新）
-    CacheMap m_cacheMap;  // 快速查找表
+    std::vector<std::unique_ptr<Node[]>> m_chunks;  // 节点池(按块分配，节点地址稳定)
+    std::vector<Slot> m_slots;                      // 快速查找表(开放寻址)
+    size_t m_slotShift = 64;
+    Policy m_policy;                       // 淘汰策略(默认 LRU: 头部最旧，尾部最新)
+    NodeIndex m_freeHead = InvalidIndex;   // 空闲节点链表
+    NodeIndex m_nodeWatermark = 0;         // 已使用过的最大节点下标
+    size_t m_count = 0;
     size_t m_totalCost = 0;
-    mutable std::mutex m_mutex;
-};
+    EXCacheNodeList<EXMemoryCache> m_detached;  // 已移除但仍被 Handle 钉住的节点
+    size_t m_detachedCost = 0;
+    std::shared_ptr<const RemovalListener> m_removalListener;
+    std::vector<Removal> m_pendingRemovals;     // 持锁期间移出、等待通知的缓存项
+    size_t m_pendingShrinks = 0;                // 正在分批淘汰的 setLimits() 调用数量
+    std::conditional_t<TTLPolicy::usesWheel, WheelState, NoWheelState> m_expiry;
+    mutable LockPolicy m_lock;
+    mutable EXCacheStatsCounters m_stats;
+};
\ No newline at end of file
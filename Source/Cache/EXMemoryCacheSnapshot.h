@@ -0,0 +1,265 @@
+//
+//  EXMemoryCacheSnapshot.h
+//
+//  Created by evanxlh on 2025/7/6.
+//
+
+#pragma once
+
+#include "EXCacheTraits.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QString>
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ 内存缓存快照: 退出前把 EXMemoryCache 中的热数据写入快照文件，下次启动时映射(mmap)快照，
+ 在缓存未命中时按需取出，避免启动初期重新解码磁盘缓存或重新下载。
+
+ 1. `save()` 按淘汰顺序(最近使用的在最后)写入所有缓存项，key/value 由 EXCacheSerializer 序列化。
+ 2. `open()` 只映射文件并还原 key 的索引；value 在第一次 `take()` 时才从映射的数据中反序列化。
+ 3. 每个缓存项只能取出一次，取出后由调用者放回内存缓存。快照不记录数据的来源是否仍然有效，
+    调用者应在 `take()` 之前自行确认(例如磁盘缓存中的 HTTP 缓存信息还新鲜)。
+
+ 文件布局: [key | value]... [索引] [尾部]，value 按 16 字节对齐，尾部记录索引位置、数量与版本。
+
+ @note 快照按本机字节序保存，只用于同一台机器上的重启，不能作为交换格式。
+ */
+template <typename Key, typename Value>
+class EXMemoryCacheSnapshot
+{
+public:
+    EXMemoryCacheSnapshot() = default;
+    EXMemoryCacheSnapshot(const EXMemoryCacheSnapshot&) = delete;
+    EXMemoryCacheSnapshot& operator=(const EXMemoryCacheSnapshot&) = delete;
+
+    ~EXMemoryCacheSnapshot() { close(); }
+
+    /**
+     把 `cache` 的全部缓存项写入 `path`(先写临时文件，成功后再替换)。
+     持锁期间只拷贝 key/value(QPixmap 等隐式共享类型只增加引用计数)，序列化在释放锁之后进行。
+     */
+    template <typename Cache>
+    static bool save(const QString& path, Cache& cache)
+    {
+        std::vector<std::pair<Key, Value>> entries;
+        cache.forEach([&entries](const Key& key, const Value& value) {
+            entries.emplace_back(key, value);
+        });
+
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) return false;
+
+        std::vector<IndexEntry> index;
+        index.reserve(entries.size());
+
+        std::string buffer;
+        uint64_t offset = 0;
+        bool succeeded = true;
+        const auto write = [&](const std::string& bytes, size_t alignment) {
+            const uint64_t padding = (alignment - offset % alignment) % alignment;
+            static const char zeros[16] = {};
+            succeeded = succeeded && file.write(zeros, static_cast<qint64>(padding)) == qint64(padding);
+            offset += padding;
+
+            const uint64_t start = offset;
+            succeeded = succeeded && file.write(bytes.data(), static_cast<qint64>(bytes.size())) == qint64(bytes.size());
+            offset += bytes.size();
+            return start;
+        };
+
+        for (const auto& [key, value] : entries) {
+            IndexEntry entry{};
+
+            buffer.clear();
+            EXCacheSerializer<Key>::serialize(key, buffer);
+            entry.keyLength = buffer.size();
+            entry.keyOffset = write(buffer, 8);
+
+            buffer.clear();
+            EXCacheSerializer<Value>::serialize(value, buffer);
+            entry.valueLength = buffer.size();
+            entry.valueOffset = write(buffer, ValueAlignment);
+
+            index.push_back(entry);
+        }
+        entries.clear();
+
+        buffer.assign(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(IndexEntry));
+        const Footer footer{ write(buffer, 8), index.size(), Magic, Version };
+        buffer.assign(reinterpret_cast<const char*>(&footer), sizeof(footer));
+        write(buffer, 8);
+
+        if (!succeeded) {
+            file.cancelWriting();
+            return false;
+        }
+        return file.commit();
+    }
+
+    // 映射快照文件并还原 key 索引，文件不存在或格式不符时返回 false
+    bool open(const QString& path)
+    {
+        close();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_file.setFileName(path);
+        if (!m_file.open(QIODevice::ReadOnly)) return false;
+
+        const qint64 size = m_file.size();
+        if (size < qint64(sizeof(Footer)) || (m_data = m_file.map(0, size)) == nullptr) {
+            _closeFile();
+            return false;
+        }
+        m_size = static_cast<uint64_t>(size);
+
+        Footer footer;
+        std::memcpy(&footer, m_data + m_size - sizeof(Footer), sizeof(Footer));
+        const uint64_t indexEnd = m_size - sizeof(Footer);
+        if (footer.magic != Magic || footer.version != Version || footer.indexOffset > indexEnd
+            || footer.count != (indexEnd - footer.indexOffset) / sizeof(IndexEntry)) {
+            _closeFile();
+            return false;
+        }
+
+        m_entries.reserve(static_cast<size_t>(footer.count));
+        for (uint64_t i = 0; i < footer.count; ++i) {
+            IndexEntry entry;
+            std::memcpy(&entry, m_data + footer.indexOffset + i * sizeof(IndexEntry), sizeof(IndexEntry));
+            if (!_isInFile(entry.keyOffset, entry.keyLength) || !_isInFile(entry.valueOffset, entry.valueLength)) {
+                continue;
+            }
+
+            auto key = EXCacheSerializer<Key>::deserialize(_bytes(entry.keyOffset, entry.keyLength));
+            if (key) {
+                m_entries.insert_or_assign(std::move(*key), Location{ entry.valueOffset, entry.valueLength });
+            }
+        }
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        _closeFile();
+    }
+
+    // 尚未取出的缓存项数量
+    size_t count() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries.size();
+    }
+
+    // 是否有尚未取出的 key，不反序列化 value
+    bool contains(const Key& key) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries.find(key) != m_entries.end();
+    }
+
+    // 丢掉 key 对应的缓存项(已经过期、被更新的数据)，不反序列化
+    void remove(const Key& key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_entries.erase(key) > 0 && m_entries.empty()) {
+            _closeFile();
+        }
+    }
+
+    // 取出 key 对应的 value(此时才反序列化)；不存在、已取出或数据无效时返回 std::nullopt
+    std::optional<Value> take(const Key& key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_entries.empty()) return std::nullopt;
+
+        auto it = m_entries.find(key);
+        if (it == m_entries.end()) return std::nullopt;
+
+        const Location location = it->second;
+        m_entries.erase(it);
+
+        // 全部取出后释放映射
+        auto value = EXCacheSerializer<Value>::deserialize(_bytes(location.offset, location.length));
+        if (m_entries.empty()) {
+            _closeFile();
+        }
+        return value;
+    }
+
+private:
+    static constexpr uint32_t Magic = 0x434D5845;  // "EXMC"
+    static constexpr uint32_t Version = 1;
+    static constexpr size_t ValueAlignment = 16;
+
+    struct IndexEntry
+    {
+        uint64_t keyOffset;
+        uint64_t keyLength;
+        uint64_t valueOffset;
+        uint64_t valueLength;
+    };
+
+    struct Footer
+    {
+        uint64_t indexOffset;
+        uint64_t count;
+        uint32_t magic;
+        uint32_t version;
+    };
+
+    struct Location
+    {
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const { return EXCacheKeyTraits<Key>::hash(key); }
+    };
+
+    struct KeyEqual
+    {
+        bool operator()(const Key& a, const Key& b) const { return EXCacheKeyTraits<Key>::equal(a, b); }
+    };
+
+    bool _isInFile(uint64_t offset, uint64_t length) const
+    {
+        return offset <= m_size && length <= m_size - offset;
+    }
+
+    std::string_view _bytes(uint64_t offset, uint64_t length) const
+    {
+        return std::string_view(reinterpret_cast<const char*>(m_data + offset), static_cast<size_t>(length));
+    }
+
+    void _closeFile()
+    {
+        if (m_data != nullptr) {
+            m_file.unmap(m_data);
+            m_data = nullptr;
+        }
+        m_size = 0;
+        if (m_file.isOpen()) {
+            m_file.close();
+        }
+        m_entries.clear();
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    QFile m_file;
+    uchar* m_data = nullptr;
+    uint64_t m_size = 0;
+    std::unordered_map<Key, Location, KeyHash, KeyEqual> m_entries;
+};
@@ -0,0 +1,352 @@
+//
+//  EXShardedMemoryCache.h
+//
+//  Created by evanxlh on 2025/7/6.
+//
+
+#pragma once
+
+#include "EXMemoryCache.h"
+
+#include <array>
+#include <functional>
+#include <vector>
+#include <tuple>
+#include <iterator>
+#include <algorithm>
+
+/**
+ 分片(锁分段)的 LRU 内存缓存: 按 key 的哈希值把缓存项分散到 N 个相互独立的 EXMemoryCache 分片中。
+
+ 1. 每个分片都有自己的锁，不同分片上的 get/put 可以在多个线程上并行执行，避免所有线程争用同一把锁。
+ 2. 每个分片独立维护淘汰队列(默认 LRU)以及 cost/count 限制，总限制按分片数平均分配(向上取整)。
+ 3. 对外保持与 EXMemoryCache 相同的 get/put/remove/clear/totalCost/count 接口。
+
+ @note 开启 `expirySweepInterval` 时每个分片都会启动自己的后台清理线程，分片较多时建议改用 `purgeExpired()`。
+
+ @note 淘汰是分片内的 LRU，而不是全局 LRU；在 key 分布均匀时两者的命中率非常接近。
+ */
+template <typename Key,
+          typename Value,
+          size_t ShardCount = 16,
+          typename LockPolicy = EXCacheMutexLock,
+          typename TTLPolicy = EXCacheNoTTL,
+          typename EvictionPolicy = EXCacheLRUPolicy>
+class EXShardedMemoryCache
+{
+    static_assert(ShardCount > 0, "ShardCount must be greater than 0");
+
+public:
+    using Shard = EXMemoryCache<Key, Value, LockPolicy, TTLPolicy, EvictionPolicy>;
+    using Config = typename Shard::Config;
+    using Handle = typename Shard::Handle;
+    using Removal = typename Shard::Removal;
+    using RemovalListener = typename Shard::RemovalListener;
+
+    explicit EXShardedMemoryCache(Config config = {})
+        : m_shards(_makeShards(config, std::make_index_sequence<ShardCount>{})) {}
+
+    template <typename K = Key>
+    std::optional<Value> get(const K& key)
+    {
+        return _shardFor(key).get(key);
+    }
+
+    // 查找并钉住缓存项，不拷贝 value(见 EXMemoryCache::pin)
+    template <typename K = Key>
+    Handle pin(const K& key)
+    {
+        return _shardFor(key).pin(key);
+    }
+
+    // 命中时在分片锁内以 `const Value&` 调用 `fn`(见 EXMemoryCache::visit)
+    template <typename K = Key, typename Fn>
+    bool visit(const K& key, Fn&& fn)
+    {
+        return _shardFor(key).visit(key, std::forward<Fn>(fn));
+    }
+
+    // 插入缓存项（完美转发）
+    template <typename K, typename V>
+    void put(K&& key, V&& value, size_t cost = Shard::AutoCost, int ttl = 0)
+    {
+        auto& shard = _shardFor(key);
+        shard.put(std::forward<K>(key), std::forward<V>(value), cost, ttl);
+    }
+
+    template <typename K = Key>
+    bool remove(const K& key)
+    {
+        return _shardFor(key).remove(key);
+    }
+
+    template <typename K = Key>
+    bool contains(const K& key) const
+    {
+        return _shardFor(key).contains(key);
+    }
+
+    // 批量查找: 按分片分组后每个分片只加一次锁，结果仍按 `keys` 的顺序写入 `out`
+    template <typename KeyRange, typename OutputIt>
+    OutputIt getMany(const KeyRange& keys, OutputIt out)
+    {
+        const auto groups = _groupByShard(keys, [](const auto& key) -> const auto& { return key; });
+
+        std::vector<std::optional<Value>> results(groups.items.size());
+        std::vector<std::optional<Value>> shardResults;
+        for (size_t shard = 0; shard < ShardCount; ++shard) {
+            const size_t begin = groups.bounds[shard];
+            const size_t end = groups.bounds[shard + 1];
+            if (begin == end) continue;
+
+            shardResults.clear();
+            m_shards[shard].cache.getMany(groups.range(begin, end), std::back_inserter(shardResults));
+            for (size_t i = begin; i < end; ++i) {
+                results[groups.positions[i]] = std::move(shardResults[i - begin]);
+            }
+        }
+        return std::move(results.begin(), results.end(), out);
+    }
+
+    // 批量插入: 按分片分组后每个分片只加一次锁、只淘汰一次；传入右值区间时 key/value 会被移动
+    template <typename EntryRange>
+    void putMany(EntryRange&& entries, int ttl = 0)
+    {
+        using Entry = std::remove_reference_t<decltype(*std::begin(entries))>;
+        constexpr bool movesEntries = !std::is_lvalue_reference_v<EntryRange> && !std::is_const_v<Entry>;
+
+        const auto groups = _groupByShard(entries, [](const auto& entry) -> const auto& {
+            return std::get<0>(entry);
+        });
+
+        for (size_t shard = 0; shard < ShardCount; ++shard) {
+            const size_t begin = groups.bounds[shard];
+            const size_t end = groups.bounds[shard + 1];
+            if (begin == end) continue;
+
+            if constexpr (movesEntries) {
+                using EntryKey = std::tuple_element_t<0, Entry>;
+                using EntryValue = std::tuple_element_t<1, Entry>;
+                std::vector<std::tuple<EntryKey&&, EntryValue&&, size_t>> moved;
+                moved.reserve(end - begin);
+                for (size_t i = begin; i < end; ++i) {
+                    Entry& entry = groups.items[i].get();
+                    moved.emplace_back(std::move(std::get<0>(entry)), std::move(std::get<1>(entry)), _entryCost(entry));
+                }
+                m_shards[shard].cache.putMany(std::move(moved), ttl);
+            } else {
+                m_shards[shard].cache.putMany(groups.range(begin, end), ttl);
+            }
+        }
+    }
+
+    // 批量删除: 按分片分组后每个分片只加一次锁，返回实际删除的数量
+    template <typename KeyRange>
+    size_t removeMany(const KeyRange& keys)
+    {
+        const auto groups = _groupByShard(keys, [](const auto& key) -> const auto& { return key; });
+
+        size_t removed = 0;
+        for (size_t shard = 0; shard < ShardCount; ++shard) {
+            const size_t begin = groups.bounds[shard];
+            const size_t end = groups.bounds[shard + 1];
+            if (begin == end) continue;
+
+            removed += m_shards[shard].cache.removeMany(groups.range(begin, end));
+        }
+        return removed;
+    }
+
+    // 清空缓存
+    void clear()
+    {
+        for (auto& slot : m_shards) {
+            slot.cache.clear();
+        }
+    }
+
+    // 运行时修改总的 cost/count 限制，按分片数平均分配；各分片依次分批淘汰(见 EXMemoryCache::setLimits)
+    void setLimits(size_t costLimit, size_t countLimit)
+    {
+        Config config;
+        config.costLimit = costLimit;
+        config.countLimit = countLimit;
+        config = _shardConfig(config);
+        for (auto& slot : m_shards) {
+            slot.cache.setLimits(config.costLimit, config.countLimit);
+        }
+    }
+
+    // 设置移除监听: 每个分片各自按批通知，同一个监听者可能在多个线程上被并发调用
+    void setRemovalListener(const RemovalListener& listener)
+    {
+        for (auto& slot : m_shards) {
+            slot.cache.setRemovalListener(listener);
+        }
+    }
+
+    // 增量清理已过期的缓存项，`budget` 为所有分片合计最多清理的数量(0: 不限制)
+    size_t purgeExpired(size_t budget = 0)
+    {
+        size_t purged = 0;
+        for (auto& slot : m_shards) {
+            if (budget > 0 && purged >= budget) break;
+            purged += slot.cache.purgeExpired(budget > 0 ? budget - purged : 0);
+        }
+        return purged;
+    }
+
+    // 缓存占用的内存字节数(各分片之和)
+    size_t totalCost() const
+    {
+        size_t total = 0;
+        for (const auto& slot : m_shards) {
+            total += slot.cache.totalCost();
+        }
+        return total;
+    }
+
+    // 缓存项数量(各分片之和)
+    size_t count() const
+    {
+        size_t total = 0;
+        for (const auto& slot : m_shards) {
+            total += slot.cache.count();
+        }
+        return total;
+    }
+
+    // 各分片统计之和，不加锁
+    EXCacheStats stats() const
+    {
+        EXCacheStats total;
+        for (const auto& slot : m_shards) {
+            total += slot.cache.stats();
+        }
+        return total;
+    }
+
+    static constexpr size_t shardCount() { return ShardCount; }
+
+    template <typename K>
+    static size_t hashKey(const K& key) { return Shard::hashKey(key); }
+
+    template <typename K>
+    static EXCacheHashedKey<K> hashedKey(K key) { return Shard::hashedKey(std::move(key)); }
+
+private:
+    // 每个分片独占缓存行，避免相邻分片的锁之间产生伪共享
+    struct alignas(64) ShardSlot
+    {
+        explicit ShardSlot(const Config& config) : cache(config) {}
+        Shard cache;
+    };
+
+    using Shards = std::array<ShardSlot, ShardCount>;
+
+    static Config _shardConfig(Config config)
+    {
+        config.costLimit = (config.costLimit + ShardCount - 1) / ShardCount;
+        config.countLimit = (config.countLimit + ShardCount - 1) / ShardCount;
+        return config;
+    }
+
+    template <size_t... I>
+    static Shards _makeShards(const Config& config, std::index_sequence<I...>)
+    {
+        const Config shardConfig = _shardConfig(config);
+        return Shards{ { ((void)I, ShardSlot(shardConfig))... } };
+    }
+
+    // 对 key 的哈希值再做一次混合: 整数等类型的 std::hash 往往是恒等映射，
+    // 直接取模会让分片选择与分片内哈希表的槽位分布相互关联。
+    static size_t _shardIndex(size_t hash)
+    {
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return hash % ShardCount;
+    }
+
+    template <typename K>
+    Shard& _shardFor(const K& key)
+    {
+        return m_shards[_shardIndex(Shard::hashKey(key))].cache;
+    }
+
+    template <typename K>
+    const Shard& _shardFor(const K& key) const
+    {
+        return m_shards[_shardIndex(Shard::hashKey(key))].cache;
+    }
+
+    /**
+     按分片分组后的批量操作元素: `items[bounds[i], bounds[i + 1])` 属于第 i 个分片，
+     `positions[j]` 为 `items[j]` 在原区间中的位置。
+     */
+    template <typename T>
+    struct ShardGroups
+    {
+        using Item = std::reference_wrapper<T>;
+
+        struct Range
+        {
+            const Item* first;
+            const Item* last;
+            const Item* begin() const { return first; }
+            const Item* end() const { return last; }
+        };
+
+        std::vector<Item> items;
+        std::vector<size_t> positions;
+        std::array<size_t, ShardCount + 1> bounds{};
+
+        Range range(size_t begin, size_t end) const { return { items.data() + begin, items.data() + end }; }
+    };
+
+    // 按分片对区间中的元素做计数排序(同一分片内保持原有顺序)，`keyOf` 从元素中取出 key
+    template <typename Range, typename KeyOf>
+    static auto _groupByShard(Range& range, KeyOf keyOf)
+    {
+        using T = std::remove_reference_t<decltype(*std::begin(range))>;
+        ShardGroups<T> groups;
+
+        std::vector<std::reference_wrapper<T>> input;
+        std::vector<uint32_t> shardIndices;
+        for (T& item : range) {
+            input.push_back(std::ref(item));
+            const auto shard = static_cast<uint32_t>(_shardIndex(Shard::hashKey(keyOf(item))));
+            shardIndices.push_back(shard);
+            ++groups.bounds[shard + 1];
+        }
+        for (size_t shard = 0; shard < ShardCount; ++shard) {
+            groups.bounds[shard + 1] += groups.bounds[shard];
+        }
+
+        std::array<size_t, ShardCount> cursor;
+        std::copy(groups.bounds.begin(), groups.bounds.end() - 1, cursor.begin());
+        groups.positions.resize(input.size());
+        for (size_t i = 0; i < input.size(); ++i) {
+            groups.positions[cursor[shardIndices[i]]++] = i;
+        }
+
+        groups.items.reserve(input.size());
+        for (size_t position : groups.positions) {
+            groups.items.push_back(input[position]);
+        }
+        return groups;
+    }
+
+    template <typename Entry>
+    static size_t _entryCost(const Entry& entry)
+    {
+        if constexpr (std::tuple_size_v<std::remove_const_t<Entry>> >= 3) {
+            return std::get<2>(entry);
+        } else {
+            return Shard::AutoCost;
+        }
+    }
+
+private:
+    Shards m_shards;
+};
@@ -0,0 +1,200 @@
+//
+//  EXTimingWheel.h
+//
+//  Created by evanxlh on 2025/7/6.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ 分层时间轮(Hierarchical Timing Wheel): 管理缓存项的过期时间，插入、删除均为 O(1)。
+
+ 1. 共 Levels 层，每层 SlotCount(64) 个槽位；第 L 层每个槽位覆盖 64^L 个 tick。
+ 2. 缓存项按"到期 tick 与当前 tick 的距离"放入能容纳它的最低一层；低层转完一圈时，
+    把高层对应槽位里的项重新分配(cascade)到更低的层。每个缓存项一生最多被移动 Levels - 1 次，
+    因此清理过期项的均摊代价是 O(1)。
+ 3. 链表指针内嵌在缓存节点中(以节点下标表示)，时间轮本身不分配内存。
+
+ `Nodes` 需要提供:
+   - `EXTimingWheelLinks& wheelLinks(uint32_t index)`
+   - `uint64_t deadlineTick(uint32_t index)`
+ */
+struct EXTimingWheelLinks
+{
+    uint32_t prev;
+    uint32_t next;
+    uint16_t slot;  // level * SlotCount + 槽位下标; NoSlot 表示不在时间轮中
+};
+
+template <typename Nodes>
+class EXTimingWheel
+{
+public:
+    static constexpr uint32_t InvalidIndex = UINT32_MAX;
+    static constexpr uint16_t NoSlot = UINT16_MAX;
+    static constexpr int Levels = 4;
+    static constexpr int SlotBits = 6;
+    static constexpr int SlotCount = 1 << SlotBits;
+
+    EXTimingWheel() { reset(0); }
+
+    // 清空时间轮(不会访问节点)，并把当前 tick 设为 `tick`
+    void reset(uint64_t tick)
+    {
+        for (auto& level : m_slots) {
+            level.fill(InvalidIndex);
+        }
+        m_currentTick = tick;
+        m_cascadedTick = tick;
+        m_size = 0;
+    }
+
+    uint64_t currentTick() const { return m_currentTick; }
+    size_t size() const { return m_size; }
+
+    void schedule(Nodes& nodes, uint32_t index)
+    {
+        // 按与下一个要处理的 tick 的距离选择层: 第 0 层的 64 个槽位恰好对应 [base, base + 63]。
+        // cascade 时 m_currentTick == tick - 1，base 就是正在 cascade 的 tick，
+        // 正在清空的高层槽位中的节点一定落到更低的层，不会放回原槽位
+        const uint64_t deadline = nodes.deadlineTick(index);
+        const uint64_t base = m_currentTick + 1;
+
+        uint16_t slot;
+        if (deadline <= base) {
+            slot = _slotOf(0, base);
+        } else {
+            slot = NoSlot;
+            for (int level = 0; level < Levels; ++level) {
+                if (deadline - base < (uint64_t(1) << (SlotBits * (level + 1)))) {
+                    slot = _slotOf(level, deadline);
+                    break;
+                }
+            }
+            if (slot == NoSlot) {
+                // 超出时间轮范围: 先放在最高层的最远槽位，cascade 时再重新计算
+                const uint64_t farthest = base + (uint64_t(1) << (SlotBits * Levels)) - 1;
+                slot = _slotOf(Levels - 1, farthest);
+            }
+        }
+
+        _link(nodes, index, slot);
+        ++m_size;
+    }
+
+    void unschedule(Nodes& nodes, uint32_t index)
+    {
+        auto& links = nodes.wheelLinks(index);
+        if (links.slot == NoSlot) return;
+
+        if (links.prev != InvalidIndex) {
+            nodes.wheelLinks(links.prev).next = links.next;
+        } else {
+            _head(links.slot) = links.next;
+        }
+        if (links.next != InvalidIndex) {
+            nodes.wheelLinks(links.next).prev = links.prev;
+        }
+        links.slot = NoSlot;
+        --m_size;
+    }
+
+    /**
+     把时间轮推进到 `nowTick`，对每个到期的节点调用 `onExpire(index)`(调用前节点已从时间轮摘除)。
+     `budget` 为本次最多处理的到期节点数(0: 不限制)；预算用完时保留进度，下次调用从断点继续。
+     返回本次处理的到期节点数。
+     */
+    template <typename OnExpire>
+    size_t advance(Nodes& nodes, uint64_t nowTick, size_t budget, OnExpire&& onExpire)
+    {
+        size_t expired = 0;
+        while (m_currentTick < nowTick) {
+            if (m_size == 0) {
+                // 时间轮为空时直接跳到目标 tick，避免逐个空转
+                m_currentTick = m_cascadedTick = nowTick;
+                break;
+            }
+
+            const uint64_t tick = m_currentTick + 1;
+            if (m_cascadedTick != tick) {
+                _cascade(nodes, tick);
+                m_cascadedTick = tick;
+            }
+
+            uint32_t& head = _head(_slotOf(0, tick));
+            while (head != InvalidIndex) {
+                if (budget > 0 && expired >= budget) return expired;
+
+                const uint32_t index = head;
+                unschedule(nodes, index);
+                if (nodes.deadlineTick(index) <= tick) {
+                    onExpire(index);
+                    ++expired;
+                } else {
+                    schedule(nodes, index);
+                }
+            }
+            m_currentTick = tick;
+        }
+        return expired;
+    }
+
+private:
+    static uint16_t _slotOf(int level, uint64_t tick)
+    {
+        return static_cast<uint16_t>(level * SlotCount + ((tick >> (SlotBits * level)) & (SlotCount - 1)));
+    }
+
+    uint32_t& _head(uint16_t slot)
+    {
+        return m_slots[slot / SlotCount][slot % SlotCount];
+    }
+
+    void _link(Nodes& nodes, uint32_t index, uint16_t slot)
+    {
+        auto& links = nodes.wheelLinks(index);
+        uint32_t& head = _head(slot);
+        links.prev = InvalidIndex;
+        links.next = head;
+        links.slot = slot;
+        if (head != InvalidIndex) {
+            nodes.wheelLinks(head).prev = index;
+        }
+        head = index;
+    }
+
+    // 低层转完一圈时，从高到低把对应槽位的节点重新分配到更低的层
+    void _cascade(Nodes& nodes, uint64_t tick)
+    {
+        // 第 L 层在 tick 为 64^L 的整数倍时转到下一个槽位
+        int topLevel = 0;
+        while (topLevel + 1 < Levels && (tick & ((uint64_t(1) << (SlotBits * (topLevel + 1))) - 1)) == 0) {
+            ++topLevel;
+        }
+
+        // 此时 m_currentTick == tick - 1，schedule() 以 tick 为基准，到期 tick == tick 的节点会落在本次要处理的第 0 层槽位
+        for (int level = topLevel; level >= 1; --level) {
+            uint32_t& head = _head(_slotOf(level, tick));
+            uint32_t index = head;
+            head = InvalidIndex;
+            while (index != InvalidIndex) {
+                auto& links = nodes.wheelLinks(index);
+                const uint32_t next = links.next;
+                links.slot = NoSlot;
+                --m_size;
+                schedule(nodes, index);
+                index = next;
+            }
+        }
+    }
+
+private:
+    std::array<std::array<uint32_t, SlotCount>, Levels> m_slots;
+    uint64_t m_currentTick = 0;
+    uint64_t m_cascadedTick = 0;
+    size_t m_size = 0;
+};
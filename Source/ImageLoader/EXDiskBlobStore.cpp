@@ -0,0 +1,790 @@
+//
+//  EXDiskBlobStore.cpp
+//
+//  Created by evanxlh on 2025/6/29.
+//
+
+#include "EXDiskBlobStore.h"
+#include <QDir>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+
+class EXDiskBlobStore::Segment
+{
+public:
+    Segment(quint32 id, const QString& path) : id(id), file(path) {}
+
+    ~Segment()
+    {
+        if (data != nullptr) {
+            file.unmap(data);
+        }
+        file.close();
+        if (discarded) {
+            QFile::remove(file.fileName());
+        }
+    }
+
+    const quint32 id;
+    QFile file;
+    uchar* data = nullptr;
+    qint64 capacity = 0;
+    qint64 used = 0;                  // 已写入的字节数，只在持有 m_writeMutex 时修改，封存后不再变化
+    qint64 liveBytes = 0;             // 有效记录的字节数，受 m_mutex 保护
+    std::atomic<bool> discarded{ false };  // 已被淘汰，最后一个引用释放时删除文件
+};
+
+EXDiskBlobStore::EXDiskBlobStore()
+{
+    m_scanPool.setMaxThreadCount(1);
+    m_maintenancePool.setMaxThreadCount(1);
+}
+
+EXDiskBlobStore::~EXDiskBlobStore()
+{
+    // 让还没开始的切换目录、正在进行的扫描与淘汰尽快结束，等待索引的线程不再等待
+    m_openRequest.fetch_add(1);
+    m_generation.fetch_add(1);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_ready.store(true, std::memory_order_release);
+        m_readyCondition.wakeAll();
+    }
+    m_scanPool.waitForDone();
+    m_maintenancePool.waitForDone();
+
+    QHash<QString, quint32> accesses;
+    _takePendingAccesses(accesses);
+    _appendJournal(_journalPath(), accesses);
+
+    QMutexLocker writeLocker(&m_writeMutex);
+    _closeActiveSegment();
+}
+
+void EXDiskBlobStore::open(const QString& directory, std::function<void()> finished)
+{
+    // 切换目录、读取最新的段与重建索引都在扫描线程中进行，调用线程(通常是 GUI 线程)不等待后台任务、不读取段文件。
+    // 切换完成之前仍使用之前的目录
+    const quint64 request = m_openRequest.fetch_add(1) + 1;
+    m_generation.fetch_add(1);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_ready.store(false, std::memory_order_release);
+    }
+
+    m_scanPool.start([this, directory, request, finished = std::move(finished)]() {
+        _open(directory, request, finished);
+    });
+}
+
+void EXDiskBlobStore::waitForReady() const
+{
+    QMutexLocker locker(&m_mutex);
+    while (!isReady()) {
+        m_readyCondition.wait(&m_mutex);
+    }
+}
+
+void EXDiskBlobStore::_open(const QString& directory, quint64 request, const std::function<void()>& finished)
+{
+    // 之后又调用了 open() 或正在析构: 由之后的任务切换；扫描线程只有一个，之前的扫描已经结束
+    if (m_openRequest.load() != request) return;
+    m_maintenancePool.waitForDone();
+
+    // 之前目录的访问记录写回之前的访问日志
+    QHash<QString, quint32> accesses;
+    QString journalPath;
+    {
+        QMutexLocker locker(&m_mutex);
+        _takePendingAccesses(accesses);
+        journalPath = _journalPath();
+    }
+    _appendJournal(journalPath, accesses);
+
+    QMutexLocker writeLocker(&m_writeMutex);
+    _closeActiveSegment();
+
+    QMutexLocker locker(&m_mutex);
+    const quint64 generation = m_generation.fetch_add(1) + 1;
+    m_directory = directory;
+    m_index.clear();
+    m_segments.clear();
+    m_removedDuringRebuild.clear();
+    m_readsSinceAging = 0;
+    m_totalSize.store(0, std::memory_order_relaxed);
+    m_liveSize.store(0, std::memory_order_relaxed);
+    m_ready.store(false, std::memory_order_release);
+
+    // 段文件名中的编号是定长的十六进制，按文件名排序即按编号排序
+    QDir().mkpath(directory);
+    QList<quint32> ids;
+    const auto names = QDir(directory).entryList({ QStringLiteral("segment-*.blob") }, QDir::Files, QDir::Name);
+    for (const QString& name : names) {
+        bool ok = false;
+        const quint32 id = name.mid(8, 8).toUInt(&ok, 16);
+        if (ok) {
+            ids.append(id);
+        }
+    }
+    m_nextSegmentId = ids.isEmpty() ? 0 : ids.last() + 1;
+    locker.unlock();
+
+    // 最新的段还有空间时继续写入它，不必每次启动都新建一个段、留下一个没写满的段；
+    // 读取它时解析出的记录交给扫描，不再解析第二遍
+    std::vector<Record> reusedRecords;
+    std::shared_ptr<Segment> reused = ids.isEmpty() ? nullptr : _reopenSegment(ids.last(), reusedRecords);
+    if (reused) {
+        locker.relock();
+        m_active = reused;
+        m_segments.emplace(reused->id, reused);
+        m_totalSize.store(reused->used, std::memory_order_relaxed);
+        locker.unlock();
+    } else {
+        _sealActiveSegment(SegmentSize);
+    }
+    writeLocker.unlock();
+
+    _scan(ids, reused, std::move(reusedRecords), generation, finished);
+}
+
+void EXDiskBlobStore::_scan(QList<quint32> ids,
+                            std::shared_ptr<Segment> reused,
+                            std::vector<Record> reusedRecords,
+                            quint64 generation,
+                            const std::function<void()>& finished)
+{
+    // 按编号从旧到新回放记录，后写入的覆盖先写入的
+    std::vector<std::shared_ptr<Segment>> segments;
+    QHash<QString, Location> index;
+    for (const quint32 id : ids) {
+        if (m_generation.load(std::memory_order_relaxed) != generation) return;
+
+        // 继续写入的段只回放 open() 时已有的记录，之后追加的记录由写入方维护
+        if (reused && reused->id == id) {
+            for (const auto& record : reusedRecords) {
+                if (record.tombstone) {
+                    index.remove(record.key);
+                } else {
+                    index.insert(record.key, Location{ reused, record.offset, record.size, record.recordSize });
+                }
+            }
+            continue;
+        }
+
+        auto segment = _openSegment(id);
+        if (!segment) continue;
+
+        qint64 end = 0;
+        const auto records = _readRecords(*segment, segment->capacity, &end);
+        segment->used = end;
+        if (records.empty()) {
+            segment->discarded = true;
+            continue;
+        }
+
+        for (const auto& record : records) {
+            if (record.tombstone) {
+                index.remove(record.key);
+            } else {
+                index.insert(record.key, Location{ segment, record.offset, record.size, record.recordSize });
+            }
+        }
+        segments.push_back(std::move(segment));
+    }
+
+    if (m_generation.load(std::memory_order_relaxed) != generation) return;
+    _replayJournal(_journalPath(), index);
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_generation.load(std::memory_order_relaxed) != generation) return;
+
+        for (const auto& segment : segments) {
+            m_segments.emplace(segment->id, segment);
+            m_totalSize.fetch_add(segment->used, std::memory_order_relaxed);
+        }
+
+        // 重建期间写入、删除的缓存项比扫描到的新
+        for (auto it = index.cbegin(); it != index.cend(); ++it) {
+            if (m_index.contains(it.key()) || m_removedDuringRebuild.contains(it.key())) continue;
+
+            m_index.insert(it.key(), it.value());
+            it.value().segment->liveBytes += it.value().recordSize;
+            m_liveSize.fetch_add(it.value().recordSize, std::memory_order_relaxed);
+        }
+        m_removedDuringRebuild.clear();
+        m_ready.store(true, std::memory_order_release);
+        m_readyCondition.wakeAll();
+    }
+
+    if (finished) {
+        finished();
+    }
+
+    // 上次退出时可能已超出上限；重建期间请求的压缩、淘汰也在这里执行
+    const qint64 maxSize = m_maxSize.load(std::memory_order_relaxed);
+    if (maxSize > 0 && totalSize() > maxSize) {
+        trim(maxSize / 10 * 9);
+    }
+    _scheduleMaintenance();
+}
+
+bool EXDiskBlobStore::contains(const QString& key) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_index.contains(key);
+}
+
+std::optional<EXDiskBlobStore::Blob> EXDiskBlobStore::read(const QString& key)
+{
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_index.find(key);
+    if (it == m_index.end()) return std::nullopt;
+
+    it->lastAccess = m_clock.fetch_add(1, std::memory_order_relaxed) + 1;
+    it->frequency = qMin(it->frequency + 1, MaxFrequency);
+
+    // 访问日志按批在后台追加；读取次数积累到一定数量后在后台减半
+    m_pendingAccesses[key] += 1;
+    if (++m_pendingAccessCount >= JournalBatchSize) {
+        QHash<QString, quint32> accesses;
+        _takePendingAccesses(accesses);
+        m_maintenancePool.start([this, path = _journalPath(), accesses = std::move(accesses)]() {
+            _appendJournal(path, accesses);
+        });
+    }
+    if (++m_readsSinceAging > qMax<qint64>(AgingInterval, m_index.size())) {
+        _scheduleMaintenance();
+    }
+
+    return Blob{ it->segment, reinterpret_cast<const char*>(it->segment->data + it->offset), it->size };
+}
+
+bool EXDiskBlobStore::write(const QString& key, const QByteArray& value)
+{
+    {
+        QMutexLocker writeLocker(&m_writeMutex);
+        const auto location = _append(key.toUtf8(), value.constData(), value.size(), RecordMagic);
+        if (!location) return false;
+
+        QMutexLocker locker(&m_mutex);
+        _publish(key, *location);
+    }
+
+    const qint64 maxSize = m_maxSize.load(std::memory_order_relaxed);
+    const qint64 total = totalSize();
+    const qint64 dead = total - m_liveSize.load(std::memory_order_relaxed);
+    if (maxSize > 0 && total > maxSize) {
+        trim(maxSize / 10 * 9);
+    } else if (dead > total / 4 && dead > SegmentSize) {
+        _scheduleMaintenance();
+    }
+    return true;
+}
+
+void EXDiskBlobStore::remove(const QString& key)
+{
+    QMutexLocker writeLocker(&m_writeMutex);
+    {
+        QMutexLocker locker(&m_mutex);
+        const auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            _dropLocation(it.value());
+            m_index.erase(it);
+        } else if (isReady()) {
+            return;
+        }
+        if (!isReady()) {
+            m_removedDuringRebuild.insert(key);
+        }
+    }
+
+    // 写入删除标记，重建索引时不会再从旧的段中恢复这个缓存项
+    _append(key.toUtf8(), nullptr, 0, TombstoneMagic);
+}
+
+void EXDiskBlobStore::clear()
+{
+    m_generation.fetch_add(1);
+    m_scanPool.waitForDone();
+    m_maintenancePool.waitForDone();
+
+    QMutexLocker writeLocker(&m_writeMutex);
+    {
+        QMutexLocker locker(&m_mutex);
+        for (auto& [id, segment] : m_segments) {
+            segment->discarded = true;
+        }
+        m_segments.clear();
+        m_index.clear();
+        m_removedDuringRebuild.clear();
+        m_pendingAccesses.clear();
+        m_pendingAccessCount = 0;
+        m_readsSinceAging = 0;
+        m_active.reset();
+        m_totalSize.store(0, std::memory_order_relaxed);
+        m_liveSize.store(0, std::memory_order_relaxed);
+        m_ready.store(true, std::memory_order_release);
+        m_readyCondition.wakeAll();
+    }
+
+    if (m_directory.isEmpty()) return;
+    QFile::remove(_journalPath());
+
+    // 扫描被中止时还有未加入段列表的段文件
+    const auto names = QDir(m_directory).entryList({ QStringLiteral("segment-*.blob") }, QDir::Files);
+    for (const QString& name : names) {
+        QFile::remove(m_directory + "/" + name);
+    }
+
+    _sealActiveSegment(SegmentSize);
+}
+
+void EXDiskBlobStore::setMaxSize(qint64 bytes)
+{
+    m_maxSize.store(bytes, std::memory_order_relaxed);
+    if (bytes > 0 && totalSize() > bytes) {
+        trim(bytes / 10 * 9);
+    }
+}
+
+void EXDiskBlobStore::trim(qint64 targetSize)
+{
+    targetSize = qMax<qint64>(0, targetSize);
+    qint64 current = m_trimTarget.load();
+    while ((current < 0 || targetSize < current) && !m_trimTarget.compare_exchange_weak(current, targetSize)) {
+    }
+    _scheduleMaintenance();
+}
+
+void EXDiskBlobStore::waitForMaintenance()
+{
+    m_maintenancePool.waitForDone();
+}
+
+int EXDiskBlobStore::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_index.size();
+}
+
+qint64 EXDiskBlobStore::_recordSize(qint64 keyLength, qint64 valueLength)
+{
+    return static_cast<qint64>(sizeof(RecordHeader)) + _align(keyLength) + _align(valueLength);
+}
+
+std::vector<EXDiskBlobStore::Record> EXDiskBlobStore::_readRecords(const Segment& segment, qint64 limit, qint64* end)
+{
+    std::vector<Record> records;
+    qint64 offset = 0;
+    while (limit - offset >= static_cast<qint64>(sizeof(RecordHeader))) {
+        RecordHeader header;
+        std::memcpy(&header, segment.data + offset, sizeof(header));
+        if ((header.magic != RecordMagic && header.magic != TombstoneMagic)
+            || header.keyLength > quint64(limit) || header.valueLength > quint64(limit)) {
+            break;
+        }
+
+        const qint64 recordSize = _recordSize(header.keyLength, static_cast<qint64>(header.valueLength));
+        if (recordSize > limit - offset) break;
+
+        const qint64 keyOffset = offset + static_cast<qint64>(sizeof(RecordHeader));
+        Record record;
+        record.key = QString::fromUtf8(reinterpret_cast<const char*>(segment.data + keyOffset), int(header.keyLength));
+        record.offset = keyOffset + _align(header.keyLength);
+        record.size = static_cast<qint64>(header.valueLength);
+        record.recordSize = recordSize;
+        record.tombstone = header.magic == TombstoneMagic;
+        records.push_back(std::move(record));
+        offset += recordSize;
+    }
+
+    if (end != nullptr) {
+        *end = offset;
+    }
+    return records;
+}
+
+QString EXDiskBlobStore::_segmentPath(quint32 id) const
+{
+    return m_directory + QStringLiteral("/segment-%1.blob").arg(id, 8, 16, QLatin1Char('0'));
+}
+
+std::shared_ptr<EXDiskBlobStore::Segment> EXDiskBlobStore::_createSegment(quint32 id, qint64 capacity)
+{
+    // 预先把文件扩展到段的大小(稀疏文件)并整体映射；写入用 write() 而不是写映射，磁盘已满时返回错误而不是 SIGBUS
+    auto segment = std::make_shared<Segment>(id, _segmentPath(id));
+    if (!segment->file.open(QIODevice::ReadWrite | QIODevice::Truncate | QIODevice::Unbuffered)
+        || !segment->file.resize(capacity)
+        || (segment->data = segment->file.map(0, capacity)) == nullptr) {
+        segment->discarded = true;
+        return nullptr;
+    }
+    segment->capacity = capacity;
+    return segment;
+}
+
+std::shared_ptr<EXDiskBlobStore::Segment> EXDiskBlobStore::_openSegment(quint32 id)
+{
+    auto segment = std::make_shared<Segment>(id, _segmentPath(id));
+    const qint64 size = segment->file.size();
+    if (size <= 0 || !segment->file.open(QIODevice::ReadOnly)
+        || (segment->data = segment->file.map(0, size)) == nullptr) {
+        segment->discarded = true;
+        return nullptr;
+    }
+    segment->capacity = size;
+    return segment;
+}
+
+std::optional<EXDiskBlobStore::Location> EXDiskBlobStore::_append(const QByteArray& key,
+                                                                  const char* value,
+                                                                  qint64 valueLength,
+                                                                  quint32 magic)
+{
+    const qint64 recordSize = _recordSize(key.size(), valueLength);
+    if (!m_active || m_active->capacity - m_active->used < recordSize) {
+        // 超过段大小的缓存项单独占用一个段
+        _sealActiveSegment(qMax(SegmentSize, recordSize));
+        if (!m_active) return std::nullopt;
+    }
+
+    Segment& segment = *m_active;
+    const qint64 start = segment.used;
+    const qint64 valueOffset = start + static_cast<qint64>(sizeof(RecordHeader)) + _align(key.size());
+
+    // 先写 value，最后写包含 magic 的记录头
+    QByteArray head(static_cast<int>(valueOffset - start), '\0');
+    const RecordHeader header{ magic, static_cast<quint32>(key.size()), static_cast<quint64>(valueLength) };
+    std::memcpy(head.data(), &header, sizeof(header));
+    std::memcpy(head.data() + sizeof(header), key.constData(), key.size());
+
+    if ((valueLength > 0 && (!segment.file.seek(valueOffset) || segment.file.write(value, valueLength) != valueLength))
+        || !segment.file.seek(start) || segment.file.write(head) != head.size()) {
+        // 这条记录没有写完整，之后的写入换到新的段，避免重建索引时在这里停止
+        _sealActiveSegment(SegmentSize);
+        return std::nullopt;
+    }
+
+    segment.used += recordSize;
+    m_totalSize.fetch_add(recordSize, std::memory_order_relaxed);
+    return Location{ m_active, valueOffset, valueLength, recordSize };
+}
+
+void EXDiskBlobStore::_publish(const QString& key, const Location& location)
+{
+    const auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        // 重新写入、搬到新的段时保留读取记录
+        _dropLocation(it.value());
+        const quint32 lastAccess = it->lastAccess;
+        const quint32 frequency = it->frequency;
+        it.value() = location;
+        it->lastAccess = lastAccess;
+        it->frequency = frequency;
+    } else {
+        m_index.insert(key, location);
+    }
+    location.segment->liveBytes += location.recordSize;
+    m_liveSize.fetch_add(location.recordSize, std::memory_order_relaxed);
+    m_removedDuringRebuild.remove(key);
+}
+
+void EXDiskBlobStore::_dropLocation(const Location& location)
+{
+    location.segment->liveBytes -= location.recordSize;
+    m_liveSize.fetch_sub(location.recordSize, std::memory_order_relaxed);
+}
+
+std::shared_ptr<EXDiskBlobStore::Segment> EXDiskBlobStore::_reopenSegment(quint32 id, std::vector<Record>& records)
+{
+    auto segment = std::make_shared<Segment>(id, _segmentPath(id));
+    const qint64 size = segment->file.size();
+    if (!segment->file.open(QIODevice::ReadWrite | QIODevice::Unbuffered)) return nullptr;
+
+    // 找到最后一条完整的记录，剩余空间不到 1/4 时不再继续写入；上次没有正常退出时文件还是整个段的大小，
+    // 截掉最后一条记录之后的数据再扩展回段的大小，新的记录后面不会残留不完整的旧数据
+    qint64 end = 0;
+    if (size > 0) {
+        segment->data = segment->file.map(0, size);
+        if (segment->data == nullptr) return nullptr;
+        records = _readRecords(*segment, size, &end);
+        segment->file.unmap(segment->data);
+        segment->data = nullptr;
+    }
+    if (end > SegmentSize * 3 / 4) return nullptr;
+
+    if (!segment->file.resize(end) || !segment->file.resize(SegmentSize)
+        || (segment->data = segment->file.map(0, SegmentSize)) == nullptr) {
+        return nullptr;
+    }
+    segment->capacity = SegmentSize;
+    segment->used = end;
+    return segment;
+}
+
+void EXDiskBlobStore::_closeActiveSegment()
+{
+    // 截掉未使用的尾部；有映射时部分平台不允许截断，失败时保留(稀疏文件不占磁盘空间)
+    if (m_active) {
+        m_active->file.resize(m_active->used);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_active.reset();
+}
+
+void EXDiskBlobStore::_sealActiveSegment(qint64 capacity)
+{
+    _closeActiveSegment();
+    if (m_directory.isEmpty()) return;
+
+    auto segment = _createSegment(m_nextSegmentId++, capacity);
+
+    QMutexLocker locker(&m_mutex);
+    m_active = segment;
+    if (segment) {
+        m_segments.emplace(segment->id, segment);
+    }
+}
+
+void EXDiskBlobStore::_scheduleMaintenance()
+{
+    if (!m_maintenanceScheduled.exchange(true)) {
+        m_maintenancePool.start([this]() {
+            _maintain();
+        });
+    }
+}
+
+void EXDiskBlobStore::_maintain()
+{
+    m_maintenanceScheduled.store(false);
+    const quint64 generation = m_generation.load();
+
+    // 重建索引期间不压缩、不淘汰: 索引中还没有继续写入的段在 open() 之前的记录，段列表中也还没有更旧的段；
+    // 淘汰目标保留在 m_trimTarget 中，扫描结束后重新调度
+    if (!isReady()) return;
+
+    // 0. 读取次数减半，只在过去读取过的缓存项才能继续被保留
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_readsSinceAging > qMax<qint64>(AgingInterval, m_index.size())) {
+            for (auto& location : m_index) {
+                location.frequency /= 2;
+            }
+            m_readsSinceAging = 0;
+        }
+    }
+
+    // 1. 压缩失效数据超过一半的段
+    std::vector<std::shared_ptr<Segment>> sparseSegments;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const auto& [id, segment] : m_segments) {
+            if (segment != m_active && segment->liveBytes * 2 < segment->used) {
+                sparseSegments.push_back(segment);
+            }
+        }
+    }
+    for (const auto& segment : sparseSegments) {
+        if (m_generation.load() != generation) return;
+        _rewriteSegment(segment, true);
+    }
+
+    // 2. 从最旧的段开始整段淘汰
+    const qint64 targetSize = m_trimTarget.exchange(-1);
+    while (targetSize >= 0 && totalSize() > targetSize && m_generation.load() == generation) {
+        std::shared_ptr<Segment> oldest;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (!m_segments.empty() && m_segments.begin()->second != m_active) {
+                oldest = m_segments.begin()->second;
+            }
+        }
+
+        if (!oldest) {
+            // 只剩正在写入的段: 封存后再淘汰
+            QMutexLocker writeLocker(&m_writeMutex);
+            if (!m_active || m_active->used == 0) break;
+            _sealActiveSegment(SegmentSize);
+            continue;
+        }
+        _rewriteSegment(oldest, false);
+    }
+}
+
+void EXDiskBlobStore::_rewriteSegment(const std::shared_ptr<Segment>& segment, bool keepAll)
+{
+    const auto records = _readRecords(*segment, segment->used);
+
+    std::vector<bool> keep(records.size(), false);
+    {
+        QMutexLocker locker(&m_mutex);
+        const bool hasOlderSegments = !m_segments.empty() && m_segments.begin()->first < segment->id;
+
+        // 淘汰时按 (读取次数, 最后读取时间) 从高到低搬走，最多搬走半个段的数据，保证每淘汰一个段总大小至少减少一半；
+        // 没有读取过或读取次数已减半到 0 的缓存项随段删除
+        std::vector<std::tuple<quint32, quint32, size_t>> candidates;
+        for (size_t i = 0; i < records.size(); ++i) {
+            const auto& record = records[i];
+            const auto it = m_index.constFind(record.key);
+            if (record.tombstone) {
+                // 更旧的段中可能还有这个 key 的数据，删除标记要保留下来
+                keep[i] = hasOlderSegments && it == m_index.cend();
+                continue;
+            }
+
+            const bool live = it != m_index.cend() && it->segment == segment && it->offset == record.offset;
+            if (!live) continue;
+
+            if (keepAll) {
+                keep[i] = true;
+            } else if (it->frequency > 0) {
+                candidates.emplace_back(it->frequency, it->lastAccess, i);
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(), std::greater<>());
+        qint64 budget = segment->used / 2;
+        for (const auto& [frequency, lastAccess, i] : candidates) {
+            if (records[i].recordSize > budget) continue;
+            budget -= records[i].recordSize;
+            keep[i] = true;
+        }
+    }
+
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (!keep[i]) continue;
+        const auto& record = records[i];
+
+        // 持有 m_writeMutex 再确认一次: 这个 key 在此之后写入、删除的记录都排在搬过去的记录后面，重建索引时不会被覆盖
+        QMutexLocker writeLocker(&m_writeMutex);
+        {
+            QMutexLocker locker(&m_mutex);
+            const auto it = m_index.constFind(record.key);
+            const bool live = it != m_index.cend() && it->segment == segment && it->offset == record.offset;
+            if (record.tombstone ? it != m_index.cend() : !live) continue;
+        }
+
+        const auto location = _append(record.key.toUtf8(),
+                                      reinterpret_cast<const char*>(segment->data + record.offset),
+                                      record.size,
+                                      record.tombstone ? TombstoneMagic : RecordMagic);
+        if (!location || record.tombstone) continue;
+
+        QMutexLocker locker(&m_mutex);
+        _publish(record.key, *location);
+    }
+
+    // 仍然指向这个段的缓存项随段一起删除
+    QMutexLocker locker(&m_mutex);
+    for (const auto& record : records) {
+        if (record.tombstone) continue;
+
+        const auto it = m_index.find(record.key);
+        if (it != m_index.end() && it->segment == segment && it->offset == record.offset) {
+            _dropLocation(it.value());
+            m_index.erase(it);
+        }
+    }
+    m_segments.erase(segment->id);
+    m_totalSize.fetch_sub(segment->used, std::memory_order_relaxed);
+    segment->discarded = true;
+}
+
+QString EXDiskBlobStore::_journalPath() const
+{
+    return m_directory.isEmpty() ? QString() : m_directory + QStringLiteral("/access.journal");
+}
+
+void EXDiskBlobStore::_takePendingAccesses(QHash<QString, quint32>& accesses)
+{
+    // 调用者持有 m_mutex，或者后台任务都已结束
+    accesses.swap(m_pendingAccesses);
+    m_pendingAccesses.clear();
+    m_pendingAccessCount = 0;
+}
+
+void EXDiskBlobStore::_appendJournal(const QString& path, const QHash<QString, quint32>& accesses)
+{
+    // 日志记录: [keyLength(quint32) | count(quint32) | key(UTF-8)]；进程中途退出留下的不完整记录在回放时忽略
+    if (path.isEmpty() || accesses.isEmpty()) return;
+
+    QByteArray bytes;
+    for (auto it = accesses.cbegin(); it != accesses.cend(); ++it) {
+        const QByteArray key = it.key().toUtf8();
+        const quint32 header[2] = { static_cast<quint32>(key.size()), it.value() };
+        bytes.append(reinterpret_cast<const char*>(header), sizeof(header));
+        bytes.append(key);
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) return;
+    file.write(bytes);
+    const qint64 size = file.size();
+    file.close();
+
+    if (size > JournalCompactSize) {
+        _compactJournal(path);
+    }
+}
+
+void EXDiskBlobStore::_compactJournal(const QString& path)
+{
+    // 改写为当前的读取次数，按最后读取时间从旧到新排列，回放后的先后顺序不变；
+    // 还没写入日志的读取已经计入索引，一并清空，避免重复计数
+    std::vector<std::tuple<quint32, QByteArray, quint32>> entries;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (path != _journalPath()) return;
+
+        for (auto it = m_index.cbegin(); it != m_index.cend(); ++it) {
+            if (it->frequency > 0) {
+                entries.emplace_back(it->lastAccess, it.key().toUtf8(), it->frequency);
+            }
+        }
+        m_pendingAccesses.clear();
+        m_pendingAccessCount = 0;
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return std::get<0>(a) < std::get<0>(b);
+    });
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return;
+    for (const auto& [lastAccess, key, frequency] : entries) {
+        const quint32 header[2] = { static_cast<quint32>(key.size()), frequency };
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(key);
+    }
+    file.commit();
+}
+
+void EXDiskBlobStore::_replayJournal(const QString& path, QHash<QString, Location>& index)
+{
+    QFile file(path);
+    if (path.isEmpty() || !file.open(QIODevice::ReadOnly)) return;
+
+    const QByteArray bytes = file.readAll();
+    qint64 offset = 0;
+    while (bytes.size() - offset >= qint64(2 * sizeof(quint32))) {
+        quint32 header[2];
+        std::memcpy(header, bytes.constData() + offset, sizeof(header));
+        offset += sizeof(header);
+        if (header[0] > quint64(bytes.size() - offset)) break;
+
+        const QString key = QString::fromUtf8(bytes.constData() + offset, int(header[0]));
+        offset += header[0];
+
+        // 按日志中的先后顺序重新分配最后读取时间
+        const auto it = index.find(key);
+        if (it != index.end()) {
+            it->frequency = static_cast<quint32>(qMin<quint64>(quint64(it->frequency) + header[1], MaxFrequency));
+            it->lastAccess = m_clock.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+    }
+}
@@ -0,0 +1,195 @@
+//
+//  EXDiskBlobStore.h
+//
+//  Created by evanxlh on 2025/6/29.
+//
+
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
+/**
+ 磁盘缓存的分段存储: 所有缓存项依次追加到固定大小的段文件(segment-xxxxxxxx.blob)中，
+ 段文件整体映射(mmap)到内存，读取时直接返回映射中的数据，不打开文件、不拷贝。
+
+ 1. 写入: 追加到当前的段，写满后新建一个段；同一个 key 再次写入时旧数据成为失效数据。
+ 2. 索引: key -> (段, 偏移, 长度) 只保存在内存中，启动时在后台顺序扫描段文件重建。
+ 3. 淘汰: 在后台整段进行。超出上限时从最旧的段开始，把其中读取次数多、最近读取过的缓存项搬到当前的段，
+    其余随段文件一起删除；失效数据超过一半的段会被压缩(搬走有效数据后删除)。
+ 4. 访问记录: 读取只更新内存中的读取次数与最后读取时间，每积累一批后在后台追加到访问日志(access.journal)，
+    不修改文件的 mtime；重建索引时回放日志恢复读取次数。读取次数定期减半，很久没有读取的缓存项不再被保留。
+
+ 记录格式: [RecordHeader | key(UTF-8) | value]，各部分按 16 字节对齐；RecordHeader 的 magic 最后写入，
+ 进程在写入中途退出时，重建索引会在这条不完整的记录处停止扫描这个段。
+
+ 所有方法都是线程安全的。
+ */
+class EXDiskBlobStore
+{
+public:
+    class Segment;
+
+    // 读取的结果；持有段的引用，段在淘汰后也要等所有 Blob 释放才会解除映射、删除文件
+    struct Blob
+    {
+        std::shared_ptr<const Segment> segment;
+        const char* data = nullptr;
+        qint64 size = 0;
+
+        // 不拷贝数据，只能在 Blob 存活期间使用
+        QByteArray bytes() const { return QByteArray::fromRawData(data, static_cast<int>(size)); }
+    };
+
+    static constexpr qint64 SegmentSize = 16 * 1024 * 1024;
+
+    EXDiskBlobStore();
+    ~EXDiskBlobStore();
+
+    EXDiskBlobStore(const EXDiskBlobStore&) = delete;
+    EXDiskBlobStore& operator=(const EXDiskBlobStore&) = delete;
+
+    /**
+     使用 `directory` 中的段文件: 最新的段还有空间时继续写入它，否则新建一个段用于写入；
+     切换目录与重建索引都在后台进行，不阻塞调用线程，完成后在后台线程调用 `finished`。
+     重建完成之前已有的缓存项读不到，新写入的缓存项可以正常读取。
+     */
+    void open(const QString& directory, std::function<void()> finished = nullptr);
+
+    // 索引是否已重建完成；完成之前 contains() 返回 false 不代表缓存项不存在
+    bool isReady() const { return m_ready.load(std::memory_order_acquire); }
+
+    // 等待索引重建完成；只应在后台线程中调用，例如读取磁盘缓存的线程池
+    void waitForReady() const;
+
+    bool contains(const QString& key) const;
+    std::optional<Blob> read(const QString& key);
+    bool write(const QString& key, const QByteArray& value);
+    void remove(const QString& key);
+
+    // 删除所有缓存项与段文件(仍被 Blob 引用的段在释放后删除)
+    void clear();
+
+    // 写入后总大小超出 `bytes` 时，在后台淘汰到上限的 90%
+    void setMaxSize(qint64 bytes);
+
+    // 在后台淘汰到总大小不超过 `targetSize`；索引重建完成之前只记录目标，重建完成后执行
+    void trim(qint64 targetSize);
+
+    // 等待后台的淘汰、压缩与访问日志写入完成
+    void waitForMaintenance();
+
+    qint64 totalSize() const { return m_totalSize.load(std::memory_order_relaxed); }
+    int count() const;
+
+private:
+    struct RecordHeader
+    {
+        quint32 magic;
+        quint32 keyLength;
+        quint64 valueLength;
+    };
+
+    struct Location
+    {
+        std::shared_ptr<Segment> segment;
+        qint64 offset = 0;       // value 在段中的偏移
+        qint64 size = 0;
+        qint64 recordSize = 0;
+        quint32 lastAccess = 0;  // 最后一次读取时的 m_clock，0 表示没有读取过
+        quint32 frequency = 0;   // 读取次数，定期减半；淘汰时优先保留读取次数多的缓存项
+    };
+
+    struct Record
+    {
+        QString key;
+        qint64 offset = 0;
+        qint64 size = 0;
+        qint64 recordSize = 0;
+        bool tombstone = false;
+    };
+
+    static constexpr quint32 RecordMagic = 0x42445845;     // "EXDB"
+    static constexpr quint32 TombstoneMagic = 0x54445845;  // "EXDT"
+    static constexpr qint64 Alignment = 16;
+    static constexpr int JournalBatchSize = 512;                  // 积累多少次读取后写一次访问日志
+    static constexpr qint64 JournalCompactSize = 4 * 1024 * 1024; // 访问日志超过这个大小时改写为当前状态的快照
+    static constexpr qint64 AgingInterval = 4096;                 // 至少读取多少次(且不少于缓存项数)后读取次数减半
+    static constexpr quint32 MaxFrequency = 0xFFFF;
+
+    static qint64 _align(qint64 value) { return (value + Alignment - 1) & ~(Alignment - 1); }
+    static qint64 _recordSize(qint64 keyLength, qint64 valueLength);
+    static std::vector<Record> _readRecords(const Segment& segment, qint64 limit, qint64* end = nullptr);
+
+    QString _segmentPath(quint32 id) const;
+    std::shared_ptr<Segment> _createSegment(quint32 id, qint64 capacity);
+    std::shared_ptr<Segment> _openSegment(quint32 id);
+    // `records` 为读到的完整记录，交给扫描，继续写入的段不必再解析一遍
+    std::shared_ptr<Segment> _reopenSegment(quint32 id, std::vector<Record>& records);
+
+    std::optional<Location> _append(const QByteArray& key, const char* value, qint64 valueLength, quint32 magic);
+    void _publish(const QString& key, const Location& location);
+    void _dropLocation(const Location& location);
+
+    // 在扫描线程中切换目录，再重建索引
+    void _open(const QString& directory, quint64 request, const std::function<void()>& finished);
+    void _scan(QList<quint32> ids,
+               std::shared_ptr<Segment> reused,
+               std::vector<Record> reusedRecords,
+               quint64 generation,
+               const std::function<void()>& finished);
+    void _scheduleMaintenance();
+    void _maintain();
+    void _rewriteSegment(const std::shared_ptr<Segment>& segment, bool keepAll);
+    // 截掉当前段未使用的尾部，不再写入它；析构、切换目录时调用
+    void _closeActiveSegment();
+    void _sealActiveSegment(qint64 capacity);
+
+    QString _journalPath() const;
+    void _takePendingAccesses(QHash<QString, quint32>& accesses);
+    void _appendJournal(const QString& path, const QHash<QString, quint32>& accesses);
+    void _compactJournal(const QString& path);
+    void _replayJournal(const QString& path, QHash<QString, Location>& index);
+
+private:
+    QString m_directory;
+
+    mutable QMutex m_mutex;                             // 保护索引、段列表与统计
+    mutable QWaitCondition m_readyCondition;            // m_ready 变为 true 时唤醒 waitForReady()
+    QHash<QString, Location> m_index;
+    std::map<quint32, std::shared_ptr<Segment>> m_segments;  // 按编号从旧到新
+    QSet<QString> m_removedDuringRebuild;
+    QHash<QString, quint32> m_pendingAccesses;          // 还没有写入访问日志的读取次数
+    int m_pendingAccessCount = 0;
+    qint64 m_readsSinceAging = 0;
+
+    QMutex m_writeMutex;                                // 串行化追加写入；加锁顺序: m_writeMutex -> m_mutex
+    std::shared_ptr<Segment> m_active;
+    quint32 m_nextSegmentId = 0;
+
+    std::atomic<qint64> m_totalSize{ 0 };               // 所有段已写入的字节数
+    std::atomic<qint64> m_liveSize{ 0 };                // 其中有效记录的字节数，其余是被覆盖、删除的失效数据
+    std::atomic<qint64> m_maxSize{ 0 };
+    std::atomic<qint64> m_trimTarget{ -1 };             // 待执行的淘汰目标，-1 表示没有
+    std::atomic<bool> m_maintenanceScheduled{ false };
+    std::atomic<bool> m_ready{ false };
+    std::atomic<quint64> m_generation{ 0 };             // 每次 open()/clear() 加一，丢弃过期的扫描结果
+    std::atomic<quint64> m_openRequest{ 0 };            // 每次 open() 加一，只有最后一次 open() 的任务切换目录
+    std::atomic<quint32> m_clock{ 0 };                  // 每次读取加一，作为最后读取时间
+
+    QThreadPool m_scanPool;
+    QThreadPool m_maintenancePool;
+};
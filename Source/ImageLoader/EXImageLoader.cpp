@@ -13,29 +13,41 @@
 #include <QStandardPaths>
 #include <QCoreApplication>
 #include <QThread>
+#include <QMutexLocker>
 #include <QDebug>
 #include <QtMinMax>
+#include <QBuffer>
+#include <QDateTime>
+#include <QRegularExpression>
+#include <charconv>
+#include <cstring>
 
 EXImageLoaderPrivate::EXImageLoaderPrivate(EXImageLoader* q)
     : q_ptr(q),
     downloader(nullptr),
     memoryCache(new EXMemoryCache<QString, QPixmap>({50 * 1024 * 1024})),
-    diskCachePath(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/image_cache"),
+    memorySnapshotPath(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/memory_cache.snapshot"),
+    diskCachePath(defaultDiskCachePath()),
     diskCacheMaxSize(200 * 1024 * 1024)
 {
     QDir dir;
     dir.mkpath(diskCachePath);
 
+    // 快照不放在磁盘缓存目录中，避免被磁盘缓存清理删除；QPixmap 只能在 QGuiApplication 存活时转换，退出前保存
+    memorySnapshot.open(memorySnapshotPath);
+    if (auto app = QCoreApplication::instance()) {
+        q->connect(app, &QCoreApplication::aboutToQuit, q, [this]() {
+            saveMemorySnapshot();
+        });
+    }
+
     m_diskMonitorTimer = new QTimer(q);
     q->connect(m_diskMonitorTimer, &QTimer::timeout, [this]() {
         monitorDiskSpace();
     });
     m_diskMonitorTimer->start(5 * 60 * 1000);
 
-    QMetaObject::invokeMethod(q, [this] {
-            m_storageInfo = QStorageInfo(diskCachePath);
-            checkDiskSpace();
-        }, Qt::QueuedConnection);
+    openDiskCache();
 }
 
 EXImageLoaderPrivate::~EXImageLoaderPrivate()
@@ -51,8 +63,92 @@ void EXImageLoaderPrivate::loadImage(const QUrl& url,
                                   const std::function<void (const QPixmap&)>& callback,
                                   ImageLoader::Priority priority,
                                   const QSize& thumbnailSize,
-                                  const EXImageProcessingChain& processingChain)
+                                  const EXImageProcessingChain& processingChain,
+                                  const std::function<void (const QPixmap&)>& progressiveCallback)
+{
+    // 命中内存缓存时不构造 QString key、不合并处理链: 复用线程内的缓冲区拼接 key，用 QStringView 查找。
+    // 剩下的一次分配是 url.toString()，QUrl 没有不分配的序列化接口
+    thread_local QString keyBuffer;
+    keyBuffer.resize(0);
+    {
+        const EXProcessingMemo& processing = effectiveProcessing(processingChain, thumbnailSize);
+        appendCacheKey(keyBuffer, url, thumbnailSize, processing.processingId);
+    }
+
+    // 钉住缓存项直接把缓存中的 QPixmap 交给回调，不拷贝
+    if (const auto cached = memoryCache->pin(QStringView(keyBuffer))) {
+        callback(*cached);
+        return;
+    }
+
+    const QString cacheKey(keyBuffer.constData(), keyBuffer.size());
+    // 回调可能在同一个线程中再次调用 loadImage() 并替换缓存的处理链，先拷贝出来
+    const EXImageProcessingChain effectiveChain = effectiveProcessing(processingChain, thumbnailSize).effectiveChain;
+
+    // 同一个 key 正在从磁盘或网络加载: 只登记回调，等那次加载完成后一起调用。
+    // 不完整的图片只在发起加载时带了 progressive 回调才会解码，之后登记的 progressive 回调从下一次部分解码开始收到
+    quint64 token = 0;
+    {
+        QMutexLocker locker(&pendingMutex);
+        EXPendingLoad& load = pendingLoads[cacheKey];
+        const bool loading = !load.callbacks.isEmpty();
+        load.callbacks.append(callback);
+        if (progressiveCallback) {
+            load.progressiveCallbacks.append(progressiveCallback);
+        }
+        if (loading) return;
+        load.token = token = ++lastPendingToken;
+    }
+
+    const auto completion = [this, cacheKey, token](const QPixmap& pixmap) {
+        completePendingLoad(cacheKey, token, pixmap);
+    };
+    std::function<void (const QPixmap&)> progressive;
+    if (progressiveCallback) {
+        progressive = [this, cacheKey, token](const QPixmap& pixmap) {
+            reportPendingProgress(cacheKey, token, pixmap);
+        };
+    }
+
+    // 索引重建完成后，不在索引中的缓存项一定不存在，直接下载；快照中的图片要先按磁盘缓存中的缓存信息确认还新鲜
+    if (diskCache.isReady()
+        && !memorySnapshot.contains(cacheKey)
+        && !diskCache.contains(rawVariantDiskKey(cacheKey, 0))
+        && !diskCache.contains(variantDiskKey(cacheKey, 0))
+        && !diskCache.contains(sourceDiskKey(url))
+        && !diskCache.contains(partialDiskKey(url))) {
+        loadFromNetwork(url, completion, priority, thumbnailSize, effectiveChain, progressive);
+        return;
+    }
+
+    loadFromDiskCacheAsync(cacheKey, url, completion, priority, thumbnailSize, effectiveChain, progressive);
+}
+
+const EXProcessingMemo& EXImageLoaderPrivate::effectiveProcessing(const EXImageProcessingChain& processingChain,
+                                                                   const QSize& thumbnailSize)
 {
+    // 处理链按步骤对象判断是否相同: 处理链的拷贝会克隆步骤，替换全局处理链后步骤对象一定不同；
+    // 缓存持有步骤的 QSharedPointer，旧的步骤对象的地址不会被新的对象复用
+    const auto sameSteps = [](const QList<QSharedPointer<EXImageProcessing>>& a,
+                              const QList<QSharedPointer<EXImageProcessing>>& b) {
+        if (a.size() != b.size()) return false;
+        for (int i = 0; i < a.size(); ++i) {
+            if (a[i].data() != b[i].data()) return false;
+        }
+        return true;
+    };
+
+    thread_local std::array<EXProcessingMemo, 8> memos;
+    thread_local size_t nextMemo = 0;
+
+    const auto& globalSteps = EXImageProcessingChain::globalChain().m_steps;
+    for (const EXProcessingMemo& memo : memos) {
+        if (memo.valid && memo.thumbnailSize == thumbnailSize
+            && sameSteps(memo.globalSteps, globalSteps) && sameSteps(memo.requestSteps, processingChain.m_steps)) {
+            return memo;
+        }
+    }
+
     EXImageProcessingChain effectiveChain =
         EXImageProcessingChain::merge(EXImageProcessingChain::globalChain(), processingChain);
 
@@ -71,124 +167,496 @@ void EXImageLoaderPrivate::loadImage(const QUrl& url,
         }
     }
 
-    const QString processingId = effectiveChain.chainIdentifier();
-    const QString cacheKey = makeCacheKey(url, thumbnailSize, processingId);
+    EXProcessingMemo& memo = memos[nextMemo];
+    nextMemo = (nextMemo + 1) % memos.size();
+    memo.globalSteps = globalSteps;
+    memo.requestSteps = processingChain.m_steps;
+    memo.thumbnailSize = thumbnailSize;
+    memo.processingId = effectiveChain.chainIdentifier();
+    memo.effectiveChain = effectiveChain;
+    memo.valid = true;
+    return memo;
+}
 
-    auto item = memoryCache->get(cacheKey);
-    if (item.has_value()) {
-        callback(item.value());
-        return;
+void EXImageLoaderPrivate::completePendingLoad(const QString& key, quint64 token, const QPixmap& pixmap)
+{
+    // cancelAll() 之后同一个 key 可能已经重新开始加载，旧的加载结束时不能取走新加载的回调
+    QList<std::function<void(const QPixmap&)>> callbacks;
+    {
+        QMutexLocker locker(&pendingMutex);
+        const auto it = pendingLoads.find(key);
+        if (it == pendingLoads.end() || it->token != token) return;
+        callbacks = it->callbacks;
+        pendingLoads.erase(it);
     }
 
-    if (auto pixmap = loadFromDiskCache(cacheKey)) {
-        memoryCache->put(cacheKey, *pixmap);
-        callback(*pixmap);
-        return;
+    // 加载失败、取消时不调用回调；之后同一个 key 的加载重新开始
+    if (pixmap.isNull()) return;
+    for (const auto& callback : callbacks) {
+        callback(pixmap);
+    }
+}
+
+void EXImageLoaderPrivate::reportPendingProgress(const QString& key, quint64 token, const QPixmap& pixmap)
+{
+    QList<std::function<void(const QPixmap&)>> callbacks;
+    {
+        QMutexLocker locker(&pendingMutex);
+        const auto it = pendingLoads.constFind(key);
+        if (it == pendingLoads.constEnd() || it->token != token) return;
+        callbacks = it->progressiveCallbacks;
+    }
+    for (const auto& callback : callbacks) {
+        callback(pixmap);
     }
+}
+
+void EXImageLoaderPrivate::loadFromDiskCacheAsync(const QString& key,
+                                                  const QUrl& url,
+                                                  const std::function<void (const QPixmap&)>& callback,
+                                                  ImageLoader::Priority priority,
+                                                  const QSize& thumbnailSize,
+                                                  const EXImageProcessingChain& processingChain,
+                                                  const std::function<void (const QPixmap&)>& progressiveCallback)
+{
+    // 读文件与解码在磁盘读取线程中进行，结果与网络下载一样在工作线程中回调；未命中时转为下载
+    diskReadPool.start([=]() {
+        // 启动时索引还在后台重建: 在读取线程中等它完成，否则已有的缓存项都读不到，只能重新下载
+        diskCache.waitForReady();
+
+        // 没有缓存信息(旧版本的缓存、本地文件)或还新鲜时直接使用，不访问网络
+        const auto metadata = loadCacheMetadata(url);
+        const quint32 generation = metadata ? metadata->generation : 0;
+        const bool stale = metadata && metadata->isStale(QDateTime::currentSecsSinceEpoch());
+        EXImageRequest::Revalidation revalidation;
+        EXImageRequest::PartialDownload partial;
+
+        if (!stale) {
+            // 上次退出时的内存缓存，确认缓存信息还新鲜之后才使用
+            if (auto pixmap = memorySnapshot.take(key)) {
+                memoryCache->put(key, *pixmap);
+                callback(*pixmap);
+                return;
+            }
+
+            // 不指定 cost: 由 EXCacheCostOf<QPixmap> 按像素数据的字节数计算，costLimit 才是真正的内存上限
+            if (auto pixmap = loadRawVariantFromDiskCache(key, generation)) {
+                memoryCache->put(key, *pixmap);
+                callback(*pixmap);
+                return;
+            }
+            if (auto pixmap = loadFromDiskCache(variantDiskKey(key, generation))) {
+                memoryCache->put(key, *pixmap);
+                callback(*pixmap);
+                return;
+            }
 
-    auto request = new EXImageRequest(url, [=](const QPixmap& result, bool fromNetwork) {
-            if (!result.isNull()) {
-                memoryCache->put(cacheKey, result);
-                if (fromNetwork) {
-                    saveToDiskCache(cacheKey, result);
+            // 没有这个尺寸/处理链的图片，但有原始数据: 在本地解码、处理，不必重新下载
+            if (auto source = loadFromDiskCache(sourceDiskKey(url))) {
+                const QPixmap pixmap = processingChain.isEmpty() ? *source : processingChain.apply(*source);
+                if (!pixmap.isNull()) {
+                    memoryCache->put(key, pixmap);
+                    saveVariantToDiskCache(key, pixmap, processingChain, generation);
+                    callback(pixmap);
+                    return;
                 }
             }
+        } else {
+            // 过期了: 快照中的图片不再使用，重新确认后以新的结果为准
+            memorySnapshot.remove(key);
+        }
+
+        if (stale && metadata->hasValidators()) {
+            // 发条件请求，内容没变时服务器只返回 304 响应头，用缓存的原始数据解码。
+            // 拷贝一份，不持有 Blob: 下载期间不钉住段文件，淘汰与压缩照常进行
+            if (const auto blob = diskCache.read(sourceDiskKey(url))) {
+                revalidation = { metadata->eTag, metadata->lastModified, QByteArray(blob->data, int(blob->size)) };
+            }
+        }
+
+        // 之前中断的下载: 从已收到的部分之后继续
+        if (revalidation.cachedData.isEmpty()) {
+            partial = loadPartialDownload(url).value_or(EXImageRequest::PartialDownload());
+        }
+
+        // 请求是 QObject，要在调度器的线程中创建: 线程池的线程没有事件循环，deleteLater() 与排队的信号都不会执行
+        QMetaObject::invokeMethod(downloader, [=]() {
+            loadFromNetwork(url, callback, priority, thumbnailSize, processingChain, progressiveCallback,
+                            revalidation, partial);
+        }, Qt::QueuedConnection);
+    }, static_cast<int>(priority));
+}
+
+void EXImageLoaderPrivate::loadFromNetwork(const QUrl& url,
+                                           const std::function<void (const QPixmap&)>& callback,
+                                           ImageLoader::Priority priority,
+                                           const QSize& thumbnailSize,
+                                           const EXImageProcessingChain& processingChain,
+                                           const std::function<void (const QPixmap&)>& progressiveCallback,
+                                           const EXImageRequest::Revalidation& revalidation,
+                                           const EXImageRequest::PartialDownload& partial)
+{
+    // 同一个 URL 的请求在调度器中合并，只增加回调: 原始数据与缓存信息由请求在回调之前保存一次，
+    // 每个变体再按新的 generation 保存一次自己处理后的图片。
+    // 失败或取消时 `result` 为空，也要调用回调，否则等待同一个 key 的回调永远不会被调用
+    auto request = new EXImageRequest(url, [callback](const QPixmap& result, const EXNetworkResponse&) {
             callback(result);
-        }, priority, thumbnailSize, effectiveChain);
+        }, priority, thumbnailSize, processingChain, progressiveCallback);
+    request->setVariantCallback([this, url](const QSize& size,
+                                            const QString& processingId,
+                                            const EXImageProcessingChain& chain,
+                                            const QPixmap& result,
+                                            const EXNetworkResponse& response) {
+        const QString variantKey = makeCacheKey(url, size, processingId);
+        memorySnapshot.remove(variantKey);
+        memoryCache->put(variantKey, result);
+        if (!url.isLocalFile() && !isNoStore(response)) {
+            const quint32 generation = loadCacheMetadata(url).value_or(EXCacheMetadata()).generation;
+            saveVariantToDiskCache(variantKey, result, chain, generation);
+        }
+    });
+    request->setRevalidation(revalidation);
+    if (!url.isLocalFile()) {
+        request->setDownloadCallback([this, url](const QByteArray& data, const EXNetworkResponse& response) {
+            if (!isNoStore(response)) {
+                saveDownloadToDiskCache(url, data, response);
+            }
+        });
+        request->setPartialDownload(partial);
+        request->setPartialDownloadCallback([this, url](const EXImageRequest::PartialDownload& interrupted) {
+            savePartialDownload(url, interrupted);
+        });
+    }
 
     downloader->enqueueRequest(request);
 }
 
-std::optional<QPixmap> EXImageLoaderPrivate::loadFromDiskCache(const QString& key)
+QString EXImageLoaderPrivate::sourceDiskKey(const QUrl& url) const
 {
-    QString filePath = diskCachePath + "/" + QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Md5).toHex();
-    QImage image(filePath);
-    auto pixmap = QPixmap::fromImage(image);
-    return pixmap.isNull() ? std::nullopt : std::make_optional(pixmap);
+    const QByteArray hash = QCryptographicHash::hash(url.toString().toUtf8(), QCryptographicHash::Md5).toHex();
+    return QString::fromLatin1(hash) + QLatin1String(".source");
 }
 
-void EXImageLoaderPrivate::saveToDiskCache(const QString& key, const QPixmap& pixmap)
+QString EXImageLoaderPrivate::metadataDiskKey(const QUrl& url) const
 {
-    if (pixmap.isNull()) return;
+    const QByteArray hash = QCryptographicHash::hash(url.toString().toUtf8(), QCryptographicHash::Md5).toHex();
+    return QString::fromLatin1(hash) + QLatin1String(".meta");
+}
 
-    checkDiskSpace();
+QString EXImageLoaderPrivate::partialDiskKey(const QUrl& url) const
+{
+    const QByteArray hash = QCryptographicHash::hash(url.toString().toUtf8(), QCryptographicHash::Md5).toHex();
+    return QString::fromLatin1(hash) + QLatin1String(".partial");
+}
 
-    QString filePath = diskCachePath + "/" + QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Md5).toHex();
-    if (!pixmap.save(filePath))
-    {
-        qDebug() << "save image failed";
+// generation 为 0 时与没有缓存信息的旧版本的 key 相同，已有的缓存仍然可用
+static QByteArray variantHash(const QString& key, quint32 generation)
+{
+    QByteArray bytes = key.toUtf8();
+    if (generation > 0) {
+        bytes += '#' + QByteArray::number(generation);
     }
+    return QCryptographicHash::hash(bytes, QCryptographicHash::Md5).toHex();
 }
 
-void EXImageLoaderPrivate::checkDiskSpace()
+QString EXImageLoaderPrivate::variantDiskKey(const QString& key, quint32 generation) const
 {
-    QDir dir(diskCachePath);
-    quint64 totalSize = 0;
-    const auto files = dir.entryInfoList(QDir::Files);
-    for (const auto& info : files) {
-        totalSize += info.size();
+    return QString::fromLatin1(variantHash(key, generation)) + QLatin1String(".variant");
+}
+
+QString EXImageLoaderPrivate::rawVariantDiskKey(const QString& key, quint32 generation) const
+{
+    return QString::fromLatin1(variantHash(key, generation)) + QLatin1String(".raw");
+}
+
+std::optional<EXCacheMetadata> EXImageLoaderPrivate::loadCacheMetadata(const QUrl& url)
+{
+    const auto blob = diskCache.read(metadataDiskKey(url));
+    if (!blob) return std::nullopt;
+
+    QDataStream in(blob->bytes());
+    quint32 magic = 0;
+    EXCacheMetadata metadata;
+    in >> magic >> metadata.generation >> metadata.lifetime >> metadata.expiresAt
+       >> metadata.eTag >> metadata.lastModified;
+    if (in.status() != QDataStream::Ok || magic != EXCacheMetadata::Magic) return std::nullopt;
+    return metadata;
+}
+
+quint32 EXImageLoaderPrivate::saveDownloadToDiskCache(const QUrl& url,
+                                                      const QByteArray& data,
+                                                      const EXNetworkResponse& response)
+{
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    const auto previous = loadCacheMetadata(url);
+
+    EXCacheMetadata metadata;
+    metadata.lifetime = freshnessLifetime(response, now);
+    if (response.statusCode == 304 && previous) {
+        // 内容没变，原始数据与处理后的图片都还能用；304 没有给出的字段沿用之前的
+        metadata.generation = previous->generation;
+        metadata.eTag = response.eTag.isEmpty() ? previous->eTag : response.eTag;
+        metadata.lastModified = response.lastModified.isEmpty() ? previous->lastModified : response.lastModified;
+        if (metadata.lifetime < 0) {
+            metadata.lifetime = previous->lifetime;
+        }
+    } else {
+        // 重新下载了内容: 之前的处理后的图片作废，留给淘汰清理
+        const QString sourceKey = sourceDiskKey(url);
+        if (previous) {
+            metadata.generation = previous->generation + 1;
+        } else if (diskCache.contains(sourceKey)) {
+            metadata.generation = 1;
+        }
+        metadata.eTag = response.eTag;
+        metadata.lastModified = response.lastModified;
+        diskCache.write(sourceKey, data);
     }
+    metadata.expiresAt = metadata.lifetime >= 0 ? now + metadata.lifetime : -1;
+
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out << EXCacheMetadata::Magic << metadata.generation << metadata.lifetime << metadata.expiresAt
+        << metadata.eTag << metadata.lastModified;
+    diskCache.write(metadataDiskKey(url), bytes);
+    return metadata.generation;
+}
 
-    bool needCleanup = (totalSize > diskCacheMaxSize * 0.9);
+std::optional<EXImageRequest::PartialDownload> EXImageLoaderPrivate::loadPartialDownload(const QUrl& url)
+{
+    const auto blob = diskCache.read(partialDiskKey(url));
+    if (!blob) return std::nullopt;
+
+    // 读出的是拷贝，不持有 Blob，下载期间不钉住段文件
+    QDataStream in(blob->bytes());
+    quint32 magic = 0;
+    EXImageRequest::PartialDownload partial;
+    in >> magic >> partial.validator >> partial.data;
+    if (in.status() != QDataStream::Ok || magic != PartialDownloadMagic
+        || partial.validator.isEmpty() || partial.data.isEmpty()) {
+        return std::nullopt;
+    }
+    return partial;
+}
 
-    m_storageInfo.refresh();
-    if (m_storageInfo.isValid()) {
-        const qint64 freeSpace = m_storageInfo.bytesAvailable();
-        const qint64 threshold = qMax(minFreeSpace, m_storageInfo.bytesTotal() / 10);
-        needCleanup = needCleanup || (freeSpace < threshold);
+void EXImageLoaderPrivate::savePartialDownload(const QUrl& url, const EXImageRequest::PartialDownload& partial)
+{
+    const QString key = partialDiskKey(url);
+    if (partial.data.size() < MinResumableBytes) {
+        if (diskCache.contains(key)) {
+            diskCache.remove(key);
+        }
+        return;
     }
 
-    if (needCleanup) {
-        cleanDiskCache();
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out << PartialDownloadMagic << partial.validator << partial.data;
+    diskCache.write(key, bytes);
+}
+
+static QList<QByteArray> cacheControlDirectives(const EXNetworkResponse& response)
+{
+    QList<QByteArray> directives = response.cacheControl.toLower().split(',');
+    for (QByteArray& directive : directives) {
+        directive = directive.trimmed();
     }
+    return directives;
 }
 
-void EXImageLoaderPrivate::cleanDiskCache()
+bool EXImageLoaderPrivate::isNoStore(const EXNetworkResponse& response)
 {
-    QDir dir(diskCachePath);
-    auto files = dir.entryInfoList(QDir::Files, QDir::Time | QDir::Reversed);
+    return cacheControlDirectives(response).contains("no-store");
+}
 
-    quint64 totalSize = 0;
-    for (const auto& file : files) {
-        totalSize += file.size();
+qint64 EXImageLoaderPrivate::freshnessLifetime(const EXNetworkResponse& response, qint64 now)
+{
+    // RFC 9111 4.2.1: max-age 优先于 Expires；no-cache 表示每次使用之前都要向服务器确认
+    const QList<QByteArray> directives = cacheControlDirectives(response);
+    if (directives.contains("no-cache")) return 0;
+
+    const qint64 age = qMax<qint64>(0, response.age.trimmed().toLongLong());
+    for (const QByteArray& directive : directives) {
+        if (directive.startsWith("max-age=")) {
+            bool ok = false;
+            const qint64 maxAge = directive.mid(8).toLongLong(&ok);
+            if (ok) return qMax<qint64>(0, maxAge - age);
+        }
     }
 
-    m_storageInfo.refresh();
-    qint64 freeSpace = m_storageInfo.bytesAvailable();
-    const qint64 targetFreeSpace = qMax(minFreeSpace, m_storageInfo.bytesTotal() / 10);
+    const qint64 date = response.date.isEmpty() ? now : parseHttpDate(response.date);
+    const qint64 responseDate = date >= 0 ? date : now;
+    if (!response.expires.isEmpty()) {
+        // 无法解析的 Expires 视为已经过期
+        const qint64 expires = parseHttpDate(response.expires);
+        return expires >= 0 ? qMax<qint64>(0, expires - responseDate - age) : 0;
+    }
 
-    qDebug() << "Starting disk cache cleanup. Current:"
-             << "Cache size:" << totalSize / (1024 * 1024) << "MB,"
-             << "Free space:" << freeSpace / (1024 * 1024) << "MB,"
-             << "Target free space:" << targetFreeSpace / (1024 * 1024) << "MB";
+    // RFC 9111 4.2.2: 没有明确的过期时间时，按距上次修改的时间的 10% 估计，最多一天
+    const qint64 lastModified = parseHttpDate(response.lastModified);
+    if (lastModified >= 0 && lastModified < responseDate) {
+        return qMin<qint64>((responseDate - lastModified) / 10, 24 * 60 * 60);
+    }
+    return -1;
+}
 
-    int removedCount = 0;
-    while (!files.isEmpty() && (freeSpace < targetFreeSpace || totalSize > diskCacheMaxSize)) {
-        const QFileInfo fileInfo = files.takeFirst();
-        const qint64 fileSize = fileInfo.size();
+qint64 EXImageLoaderPrivate::parseHttpDate(const QByteArray& value)
+{
+    static const char* const months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                          "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
 
-        if (QFile::remove(fileInfo.absoluteFilePath())) {
-            totalSize -= fileSize;
-            removedCount++;
-            freeSpace += fileSize;
-        }
+    const int comma = value.indexOf(',');
+    const QList<QByteArray> parts = value.mid(comma + 1).simplified().split(' ');
+    if (comma < 0 || parts.size() != 5 || parts[4] != "GMT") return -1;
 
-        if (removedCount % 10 == 0) {
-            m_storageInfo.refresh();
-            freeSpace = m_storageInfo.bytesAvailable();
-        }
+    int month = 0;
+    while (month < 12 && parts[1] != months[month]) ++month;
+    const QDate date(parts[2].toInt(), month + 1, parts[0].toInt());
+    const QTime time = QTime::fromString(QString::fromLatin1(parts[3]), QStringLiteral("HH:mm:ss"));
+    if (month == 12 || !date.isValid() || !time.isValid()) return -1;
+
+    return QDate(1970, 1, 1).daysTo(date) * 24 * 60 * 60 + time.msecsSinceStartOfDay() / 1000;
+}
+
+std::optional<QPixmap> EXImageLoaderPrivate::loadFromDiskCache(const QString& diskKey)
+{
+    // 直接从映射的段文件中解码，不打开文件、不拷贝编码数据
+    const auto blob = diskCache.read(diskKey);
+    if (!blob) return std::nullopt;
+
+    auto pixmap = QPixmap::fromImage(QImage::fromData(blob->bytes()));
+    return pixmap.isNull() ? std::nullopt : std::make_optional(pixmap);
+}
+
+std::optional<QPixmap> EXImageLoaderPrivate::loadRawVariantFromDiskCache(const QString& key, quint32 generation)
+{
+    const auto blob = diskCache.read(rawVariantDiskKey(key, generation));
+    if (!blob || blob->size < qint64(sizeof(EXRawPixelHeader))) return std::nullopt;
+
+    EXRawPixelHeader header;
+    std::memcpy(&header, blob->data, sizeof(header));
+    if (header.magic != EXRawPixelHeader::Magic || header.width == 0 || header.height == 0
+        || header.bytesPerLine < header.width * 4
+        || blob->size != qint64(sizeof(header)) + qint64(header.bytesPerLine) * header.height) {
+        return std::nullopt;
+    }
+
+    // 映射中的像素不需要解码，拷贝一次即可；结果会进入内存缓存，不能引用映射，否则会一直钉住整个段文件，
+    // 段被淘汰、压缩后文件也删不掉。拷贝完成前 blob 持有段，映射不会解除
+    const QImage view(reinterpret_cast<const uchar*>(blob->data + sizeof(header)),
+                      int(header.width), int(header.height), int(header.bytesPerLine),
+                      QImage::Format_ARGB32_Premultiplied);
+    auto pixmap = QPixmap::fromImage(view.copy());
+    return pixmap.isNull() ? std::nullopt : std::make_optional(pixmap);
+}
+
+void EXImageLoaderPrivate::saveVariantToDiskCache(const QString& key,
+                                                  const QPixmap& pixmap,
+                                                  const EXImageProcessingChain& processingChain,
+                                                  quint32 generation)
+{
+    // 没有处理的图片与原始数据解码的结果相同，不必再存一份
+    if (pixmap.isNull() || processingChain.isEmpty() || !q_ptr->config()->storeProcessedVariants()) return;
+
+    // 小图(缩略图)保存未压缩的预乘像素，读取时省去解码；大图仍压缩保存，避免占用过多磁盘空间
+    const qint64 rawBytes = qint64(pixmap.width()) * pixmap.height() * 4;
+    if (rawBytes <= q_ptr->config()->maxRawVariantBytes()) {
+        const QImage image = pixmap.toImage().convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        const EXRawPixelHeader header{ EXRawPixelHeader::Magic, quint32(image.width()), quint32(image.height()),
+                                       quint32(image.bytesPerLine()) };
+        QByteArray bytes;
+        bytes.reserve(int(sizeof(header) + image.sizeInBytes()));
+        bytes.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        bytes.append(reinterpret_cast<const char*>(image.constBits()), int(image.sizeInBytes()));
+        diskCache.write(rawVariantDiskKey(key, generation), bytes);
+        return;
+    }
+
+    // 按图片选择解码快的格式: 不透明的图片用 JPEG，带透明通道的用低压缩级别的 PNG
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    const bool saved = pixmap.hasAlphaChannel() ? pixmap.save(&buffer, "PNG", 90)
+                                                : pixmap.save(&buffer, "JPG", 90);
+    if (!saved) {
+        qDebug() << "save image failed";
+        return;
+    }
 
-        if (freeSpace >= targetFreeSpace && totalSize <= diskCacheMaxSize) {
-            break;
+    diskCache.write(variantDiskKey(key, generation), bytes);
+}
+
+void EXImageLoaderPrivate::openDiskCache()
+{
+    m_storageInfo = QStorageInfo(diskCachePath);
+    diskCache.setMaxSize(diskCacheMaxSize);
+
+    // 索引在后台重建，完成后再检查一次磁盘空间。
+    // 旧版本每个缓存项一个文件的缓存只在默认目录中删除，并且只删除一次: setDiskCachePath() 指定的目录可能与其他程序共用，
+    // 同名的文件不一定是旧版本的缓存
+    EXImageLoader* const q = q_ptr;
+    const QString path = diskCachePath;
+    const bool ownsDirectory = QDir(path) == QDir(defaultDiskCachePath());
+    diskCache.open(path, [this, q, path, ownsDirectory]() {
+        const QString marker = path + QStringLiteral("/legacy_cache.removed");
+        if (ownsDirectory && !QFile::exists(marker)) {
+            static const QRegularExpression legacyName(QStringLiteral("^[0-9a-f]{32}(\\.source|\\.variant)?$"));
+            const auto names = QDir(path).entryList(QDir::Files);
+            for (const QString& name : names) {
+                if (legacyName.match(name).hasMatch()) {
+                    QFile::remove(path + "/" + name);
+                }
+            }
+            QFile file(marker);
+            file.open(QIODevice::WriteOnly);
         }
+        QMetaObject::invokeMethod(q, [this] { checkDiskSpace(); }, Qt::QueuedConnection);
+    });
+}
+
+QString EXImageLoaderPrivate::defaultDiskCachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/image_cache";
+}
+
+void EXImageLoaderPrivate::checkDiskSpace()
+{
+    m_storageInfo.refresh();
+    if (!m_storageInfo.isValid()) return;
+
+    const qint64 freeSpace = m_storageInfo.bytesAvailable();
+    const qint64 threshold = qMax(minFreeSpace, m_storageInfo.bytesTotal() / 10);
+    if (freeSpace < threshold) {
+        cleanDiskCache();
     }
+}
 
+void EXImageLoaderPrivate::cleanDiskCache()
+{
+    // 缓存大小的上限由 EXDiskBlobStore 在写入时维护，这里只处理磁盘剩余空间不足
     m_storageInfo.refresh();
-    freeSpace = m_storageInfo.bytesAvailable();
+    const qint64 freeSpace = m_storageInfo.bytesAvailable();
+    const qint64 targetFreeSpace = qMax(minFreeSpace, m_storageInfo.bytesTotal() / 10);
+    const qint64 cacheSize = diskCache.totalSize();
+    const qint64 sizeLimit = diskCacheMaxSize > 0 ? diskCacheMaxSize / 10 * 9 : cacheSize;
+    const qint64 targetSize = qMin<qint64>(sizeLimit, cacheSize - qMax<qint64>(0, targetFreeSpace - freeSpace));
+
+    qDebug() << "Starting disk cache cleanup. Current:"
+             << "Cache size:" << cacheSize / (1024 * 1024) << "MB,"
+             << "Free space:" << freeSpace / (1024 * 1024) << "MB,"
+             << "Target cache size:" << qMax<qint64>(0, targetSize) / (1024 * 1024) << "MB";
 
-    qDebug() << "Disk cache cleanup finished. Removed" << removedCount << "files."
-             << "Current cache size:" << totalSize / (1024 * 1024) << "MB,"
-             << "Free space:" << freeSpace / (1024 * 1024) << "MB";
+    // 在后台整段淘汰
+    diskCache.trim(targetSize);
+}
+
+void EXImageLoaderPrivate::saveMemorySnapshot()
+{
+    // 先释放旧快照的映射，才能替换文件
+    memorySnapshot.close();
+    if (!EXMemoryCacheSnapshot<QString, QPixmap>::save(memorySnapshotPath, *memoryCache)) {
+        qWarning() << "save memory cache snapshot failed:" << memorySnapshotPath;
+    }
 }
 
 void EXImageLoaderPrivate::monitorDiskSpace()
@@ -214,11 +682,29 @@ QString EXImageLoaderPrivate::makeCacheKey(const QUrl& url,
                                         const QSize& size,
                                         const QString& processingId) const
 {
-    return QString("%1_%2x%3_%4")
-        .arg(url.toString())
-        .arg(size.width())
-        .arg(size.height())
-        .arg(processingId);
+    QString key;
+    appendCacheKey(key, url, size, processingId);
+    return key;
+}
+
+void EXImageLoaderPrivate::appendCacheKey(QString& out,
+                                          const QUrl& url,
+                                          const QSize& size,
+                                          const QString& processingId) const
+{
+    char digits[16];
+    const auto appendNumber = [&out, &digits](int value) {
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out += QLatin1String(digits, static_cast<int>(result.ptr - digits));
+    };
+
+    out += url.toString();
+    out += QLatin1Char('_');
+    appendNumber(size.width());
+    out += QLatin1Char('x');
+    appendNumber(size.height());
+    out += QLatin1Char('_');
+    out += processingId;
 }
 
 EXImageLoader::EXImageLoader(QObject *parent)
@@ -233,20 +719,30 @@ EXImageLoader::EXImageLoader(QObject *parent)
             this, &EXImageLoader::concurrentCountChanged);
     connect(d->downloader, &EXImageRequestScheduler::requestQueueOverflow,
             this, &EXImageLoader::requestQueueOverflow);
+
+    d->diskReadPool.setMaxThreadCount(qMax(1, m_config->maxConcurrentDiskReads()));
+    connect(m_config.data(), &EXImageLoaderConfiguration::maxConcurrentDiskReadsChanged, this, [d](int count) {
+        d->diskReadPool.setMaxThreadCount(qMax(1, count));
+    });
 }
 
 EXImageLoader::~EXImageLoader()
 {
+    Q_D(EXImageLoader);
+    // 磁盘读取任务未命中时会访问配置与下载调度器，先等它们结束
+    d->diskReadPool.clear();
+    d->diskReadPool.waitForDone();
 }
 
 void EXImageLoader::loadImage(const QUrl& url,
                            const std::function<void (const QPixmap&)>& callback,
                            ImageLoader::Priority priority,
                            const QSize& thumbnailSize,
-                           const EXImageProcessingChain& processingChain)
+                           const EXImageProcessingChain& processingChain,
+                           const std::function<void (const QPixmap&)>& progressiveCallback)
 {
     Q_D(EXImageLoader);
-    d->loadImage(url, callback, priority, thumbnailSize, processingChain);
+    d->loadImage(url, callback, priority, thumbnailSize, processingChain, progressiveCallback);
 }
 
 void EXImageLoader::cancelLoad(const QUrl& url, const QString& processingId)
@@ -259,13 +755,17 @@ void EXImageLoader::cancelLoad(const QUrl& url, const QString& processingId)
 void EXImageLoader::cancelAll()
 {
     Q_D(EXImageLoader);
+    d->diskReadPool.clear();
     d->downloader->cancelAll();
+    // 清掉的磁盘读取任务不会再调用回调，之后同一个 key 的加载重新开始
+    QMutexLocker locker(&d->pendingMutex);
+    d->pendingLoads.clear();
 }
 
 void EXImageLoader::setMaxMemoryUsage(quint64 bytes)
 {
     Q_D(EXImageLoader);
-    // d->memoryCache->setCapacity(bytes);
+    d->memoryCache->setLimits(static_cast<size_t>(bytes), 0);
 }
 
 void EXImageLoader::setDiskCachePath(const QString& path, quint64 maxSize)
@@ -274,6 +774,7 @@ void EXImageLoader::setDiskCachePath(const QString& path, quint64 maxSize)
     d->diskCachePath = path;
     d->diskCacheMaxSize = maxSize;
     QDir().mkpath(path);
+    d->openDiskCache();
 }
 
 void EXImageLoader::setMinFreeSpace(quint64 bytes)
@@ -291,21 +792,29 @@ EXImageLoader* EXImageLoader::globalInstance()
 QPixmap EXImageLoader::cachedImage(const QUrl& url) const
 {
     Q_D(const EXImageLoader);
-    return d->memoryCache->get(d->makeCacheKey(url, QSize(), QString())).value();
+    if (const auto cached = d->memoryCache->pin(d->makeCacheKey(url, QSize(), QString()))) {
+        return *cached;
+    }
+    return QPixmap();
+}
+
+EXCacheStats EXImageLoader::memoryCacheStats() const
+{
+    Q_D(const EXImageLoader);
+    return d->memoryCache->stats();
 }
 
 void EXImageLoader::clearMemoryCache()
 {
     Q_D(EXImageLoader);
     d->memoryCache->clear();
+    d->memorySnapshot.close();
 }
 
 void EXImageLoader::clearDiskCache()
 {
     Q_D(EXImageLoader);
-    QDir dir(d->diskCachePath);
-    dir.removeRecursively();
-    dir.mkpath(d->diskCachePath);
+    d->diskCache.clear();
 }
 
 void EXImageLoader::setMaxConcurrentDownloads(int maxConcurrent)
@@ -8,6 +8,7 @@
 
 #include "EXImageLoaderConfiguration.h"
 #include "EXImageProcessing.h"
+#include "../Cache/EXCacheStats.h"
 #include <QObject>
 #include <QUrl>
 #include <QPixmap>
@@ -23,11 +24,13 @@ public:
     explicit EXImageLoader(QObject *parent = nullptr);
     ~EXImageLoader();
 
+    // 加载成功时调用 `callback`；失败或被取消时不调用。`progressiveCallback` 在下载过程中收到不完整的图片
     void loadImage(const QUrl& url,
                    const std::function<void(const QPixmap&)>& callback,
                    ImageLoader::Priority priority = ImageLoader::Priority::Medium,
                    const QSize& thumbnailSize = QSize(),
-                   const EXImageProcessingChain& processingChain = EXImageProcessingChain());
+                   const EXImageProcessingChain& processingChain = EXImageProcessingChain(),
+                   const std::function<void(const QPixmap&)>& progressiveCallback = nullptr);
 
     void cancelLoad(const QUrl& url, const QString& processingId = QString());
     void cancelAll();
@@ -39,6 +42,7 @@ public:
     static EXImageLoader* globalInstance();
 
     QPixmap cachedImage(const QUrl& url) const;
+    EXCacheStats memoryCacheStats() const;
     void clearMemoryCache();
     void clearDiskCache();
 
@@ -50,3 +50,55 @@ void EXImageLoaderConfiguration::setAdaptiveScaling(bool enabled)
         emit adaptiveScalingChanged(enabled);
     }
 }
+
+int EXImageLoaderConfiguration::maxConcurrentDiskReads() const
+{
+    return m_maxConcurrentDiskReads;
+}
+
+void EXImageLoaderConfiguration::setMaxConcurrentDiskReads(int count)
+{
+    if (m_maxConcurrentDiskReads != count) {
+        m_maxConcurrentDiskReads = count;
+        emit maxConcurrentDiskReadsChanged(count);
+    }
+}
+
+bool EXImageLoaderConfiguration::storeProcessedVariants() const
+{
+    return m_storeProcessedVariants;
+}
+
+void EXImageLoaderConfiguration::setStoreProcessedVariants(bool enabled)
+{
+    if (m_storeProcessedVariants != enabled) {
+        m_storeProcessedVariants = enabled;
+        emit storeProcessedVariantsChanged(enabled);
+    }
+}
+
+int EXImageLoaderConfiguration::maxRawVariantBytes() const
+{
+    return m_maxRawVariantBytes;
+}
+
+void EXImageLoaderConfiguration::setMaxRawVariantBytes(int bytes)
+{
+    if (m_maxRawVariantBytes != bytes) {
+        m_maxRawVariantBytes = bytes;
+        emit maxRawVariantBytesChanged(bytes);
+    }
+}
+
+int EXImageLoaderConfiguration::progressiveDecodeInterval() const
+{
+    return m_progressiveDecodeInterval;
+}
+
+void EXImageLoaderConfiguration::setProgressiveDecodeInterval(int bytes)
+{
+    if (m_progressiveDecodeInterval != bytes) {
+        m_progressiveDecodeInterval = bytes;
+        emit progressiveDecodeIntervalChanged(bytes);
+    }
+}
@@ -14,6 +14,10 @@ class EXImageLoaderConfiguration : public QObject
     Q_PROPERTY(int maxConcurrent READ maxConcurrent WRITE setMaxConcurrent NOTIFY maxConcurrentChanged)
     Q_PROPERTY(int queueCapacity READ queueCapacity WRITE setQueueCapacity NOTIFY queueCapacityChanged)
     Q_PROPERTY(bool adaptiveScaling READ adaptiveScaling WRITE setAdaptiveScaling NOTIFY adaptiveScalingChanged)
+    Q_PROPERTY(int maxConcurrentDiskReads READ maxConcurrentDiskReads WRITE setMaxConcurrentDiskReads NOTIFY maxConcurrentDiskReadsChanged)
+    Q_PROPERTY(bool storeProcessedVariants READ storeProcessedVariants WRITE setStoreProcessedVariants NOTIFY storeProcessedVariantsChanged)
+    Q_PROPERTY(int maxRawVariantBytes READ maxRawVariantBytes WRITE setMaxRawVariantBytes NOTIFY maxRawVariantBytesChanged)
+    Q_PROPERTY(int progressiveDecodeInterval READ progressiveDecodeInterval WRITE setProgressiveDecodeInterval NOTIFY progressiveDecodeIntervalChanged)
 
 public:
     explicit EXImageLoaderConfiguration(QObject *parent = nullptr);
@@ -27,13 +31,38 @@ public:
     bool adaptiveScaling() const;
     void setAdaptiveScaling(bool enabled);
 
+    // 同时读取、解码磁盘缓存的线程数，与网络下载的并发数分开限制
+    int maxConcurrentDiskReads() const;
+    void setMaxConcurrentDiskReads(int count);
+
+    // 除原始数据外，是否把缩放/处理后的图片也写入磁盘缓存；关闭后每次都从原始数据重新解码、处理
+    bool storeProcessedVariants() const;
+    void setStoreProcessedVariants(bool enabled);
+
+    // 像素数据不超过这个字节数的处理后图片以未压缩的像素保存，读取时不解码；0 表示全部压缩保存
+    int maxRawVariantBytes() const;
+    void setMaxRawVariantBytes(int bytes);
+
+    // 边下载边解码时，解码器每多读取这么多字节、追上已收到的数据时交出一次不完整的图片，交给加载时的 progressive 回调；
+    // 0 表示不边下载边解码
+    int progressiveDecodeInterval() const;
+    void setProgressiveDecodeInterval(int bytes);
+
 signals:
     void maxConcurrentChanged(int count);
     void queueCapacityChanged(int capacity);
     void adaptiveScalingChanged(bool enabled);
+    void maxConcurrentDiskReadsChanged(int count);
+    void storeProcessedVariantsChanged(bool enabled);
+    void maxRawVariantBytesChanged(int bytes);
+    void progressiveDecodeIntervalChanged(int bytes);
 
 private:
     int m_maxConcurrent = 8;
     int m_queueCapacity = 100;
     bool m_adaptiveScaling = true;
+    int m_maxConcurrentDiskReads = 2;
+    bool m_storeProcessedVariants = true;
+    int m_maxRawVariantBytes = 256 * 1024;
+    int m_progressiveDecodeInterval = 64 * 1024;
 };
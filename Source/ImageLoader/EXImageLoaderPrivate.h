@@ -8,9 +8,14 @@
 
 #include "EXImageLoader.h"
 #include "EXImageRequestScheduler.h"
+#include "EXDiskBlobStore.h"
 #include "../Cache/EXMemoryCache.h"
+#include "../Cache/EXMemoryCacheSnapshot.h"
 #include <QHash>
+#include <QList>
+#include <QMutex>
 #include <QSet>
+#include <array>
 #include <optional>
 #include <QDir>
 #include <QStandardPaths>
@@ -21,10 +26,61 @@
 #include <QFile>
 #include <QDataStream>
 #include <QTimer>
+#include <QThreadPool>
+
+// 未压缩保存的处理后图片: [RawPixelHeader | 预乘 ARGB32 像素]，像素紧跟在 16 字节的头后面，与段中的 value 一样 16 字节对齐
+struct EXRawPixelHeader
+{
+    static constexpr quint32 Magic = 0x50525845;  // "EXRP"
+
+    quint32 magic;
+    quint32 width;
+    quint32 height;
+    quint32 bytesPerLine;
+};
+static_assert(sizeof(EXRawPixelHeader) == 16, "pixels must stay 16-byte aligned");
+
+// 原始数据的 HTTP 缓存信息，按 URL 与原始数据一起保存在磁盘缓存中
+struct EXCacheMetadata
+{
+    static constexpr quint32 Magic = 0x4d435845;  // "EXCM"
+
+    quint32 generation = 0;   // 原始数据被重新下载的次数；处理后的图片的 key 包含它，内容变化后旧的图片不再被读取
+    qint64 lifetime = -1;     // 新鲜的秒数，-1 表示响应没有给出，一直视为新鲜
+    qint64 expiresAt = -1;    // 过期时间(UTC 秒)
+    QByteArray eTag;
+    QByteArray lastModified;
+
+    bool isStale(qint64 now) const { return lifetime >= 0 && now >= expiresAt; }
+    bool hasValidators() const { return !eTag.isEmpty() || !lastModified.isEmpty(); }
+};
+
+// 请求的处理链与缩略图尺寸对应的实际处理链(合并全局处理链、补上缩放)与它的标识
+struct EXProcessingMemo
+{
+    QList<QSharedPointer<EXImageProcessing>> globalSteps;
+    QList<QSharedPointer<EXImageProcessing>> requestSteps;
+    QSize thumbnailSize;
+    EXImageProcessingChain effectiveChain;
+    QString processingId;
+    bool valid = false;
+};
+
+// 正在从磁盘或网络加载的一个缓存 key: 同一个 key 的加载只登记回调，共用一次加载的结果
+struct EXPendingLoad
+{
+    QList<std::function<void(const QPixmap&)>> callbacks;
+    QList<std::function<void(const QPixmap&)>> progressiveCallbacks;
+    quint64 token = 0;  // 每次加载不同，用来忽略 cancelAll() 之前开始的加载的结果
+};
 
 class EXImageLoaderPrivate
 {
 public:
+    static constexpr quint32 PartialDownloadMagic = 0x50445845;  // "EXDP"
+    // 中断时至少收到这么多字节才保存下来继续下载，小图直接重新下载
+    static constexpr int MinResumableBytes = 256 * 1024;
+
     EXImageLoaderPrivate(EXImageLoader* q);
     ~EXImageLoaderPrivate();
 
@@ -32,22 +88,82 @@ public:
                    const std::function<void(const QPixmap&)>& callback,
                    ImageLoader::Priority priority,
                    const QSize& thumbnailSize,
-                   const EXImageProcessingChain& processingChain);
+                   const EXImageProcessingChain& processingChain,
+                   const std::function<void(const QPixmap&)>& progressiveCallback);
 
-    std::optional<QPixmap> loadFromDiskCache(const QString& key);
-    void saveToDiskCache(const QString& key, const QPixmap& pixmap);
+    void loadFromDiskCacheAsync(const QString& key,
+                                const QUrl& url,
+                                const std::function<void(const QPixmap&)>& callback,
+                                ImageLoader::Priority priority,
+                                const QSize& thumbnailSize,
+                                const EXImageProcessingChain& processingChain,
+                                const std::function<void(const QPixmap&)>& progressiveCallback);
+    // 缓存 key 由请求的每个变体按 URL、缩略图尺寸与处理链的标识生成
+    void loadFromNetwork(const QUrl& url,
+                         const std::function<void(const QPixmap&)>& callback,
+                         ImageLoader::Priority priority,
+                         const QSize& thumbnailSize,
+                         const EXImageProcessingChain& processingChain,
+                         const std::function<void(const QPixmap&)>& progressiveCallback,
+                         const EXImageRequest::Revalidation& revalidation = EXImageRequest::Revalidation(),
+                         const EXImageRequest::PartialDownload& partial = EXImageRequest::PartialDownload());
+    // 同一个线程中最近用过的几组处理链直接复用，命中内存缓存时不再合并处理链、生成标识
+    static const EXProcessingMemo& effectiveProcessing(const EXImageProcessingChain& processingChain,
+                                                       const QSize& thumbnailSize);
+    void completePendingLoad(const QString& key, quint64 token, const QPixmap& pixmap);
+    void reportPendingProgress(const QString& key, quint64 token, const QPixmap& pixmap);
+    std::optional<QPixmap> loadFromDiskCache(const QString& diskKey);
+    std::optional<QPixmap> loadRawVariantFromDiskCache(const QString& key, quint32 generation);
+    void saveVariantToDiskCache(const QString& key,
+                                const QPixmap& pixmap,
+                                const EXImageProcessingChain& processingChain,
+                                quint32 generation);
+    std::optional<EXCacheMetadata> loadCacheMetadata(const QUrl& url);
+    // 保存下载的原始数据(304 时只更新缓存信息)，返回之后保存处理后的图片要用的 generation
+    quint32 saveDownloadToDiskCache(const QUrl& url, const QByteArray& data, const EXNetworkResponse& response);
+    std::optional<EXImageRequest::PartialDownload> loadPartialDownload(const QUrl& url);
+    // 保存中断的下载；`partial` 不够大或为空时删除之前保存的部分
+    void savePartialDownload(const QUrl& url, const EXImageRequest::PartialDownload& partial);
+    void openDiskCache();
+    // 构造时使用的磁盘缓存目录，只有这个目录完全归加载器所有
+    static QString defaultDiskCachePath();
     void checkDiskSpace();
     void monitorDiskSpace();
     void cleanDiskCache();
+    void saveMemorySnapshot();
+    // 磁盘缓存的 key: 原始数据与缓存信息按 URL 保存，处理后的图片按完整的缓存 key 与原始数据的 generation 保存
+    QString sourceDiskKey(const QUrl& url) const;
+    QString metadataDiskKey(const QUrl& url) const;
+    QString partialDiskKey(const QUrl& url) const;
+    QString variantDiskKey(const QString& key, quint32 generation) const;
+    QString rawVariantDiskKey(const QString& key, quint32 generation) const;
+
+    // Cache-Control: no-store 的响应不写入磁盘缓存
+    static bool isNoStore(const EXNetworkResponse& response);
+    // 按 Cache-Control、Expires 或 Last-Modified 计算新鲜的秒数，-1 表示没有给出
+    static qint64 freshnessLifetime(const EXNetworkResponse& response, qint64 now);
+    // IMF-fixdate("Sun, 06 Nov 1994 08:49:37 GMT")，返回 UTC 秒；格式不对时返回 -1
+    static qint64 parseHttpDate(const QByteArray& value);
 
     QString makeCacheKey(const QUrl& url,
                          const QSize& size,
                          const QString& processingId) const;
+    void appendCacheKey(QString& out,
+                        const QUrl& url,
+                        const QSize& size,
+                        const QString& processingId) const;
 
     EXImageLoader* const q_ptr;
     EXImageRequestScheduler* downloader;
     EXMemoryCache<QString, QPixmap>* memoryCache;
+    EXMemoryCacheSnapshot<QString, QPixmap> memorySnapshot;  // 上次退出时的内存缓存，未命中时按需取出
+    QString memorySnapshotPath;
     QString diskCachePath;
+    EXDiskBlobStore diskCache;        // 分段存储的磁盘缓存，淘汰与压缩在后台整段进行
+    QThreadPool diskReadPool;         // 读取、解码磁盘缓存，不占用调用线程与下载线程
+    QMutex pendingMutex;
+    QHash<QString, EXPendingLoad> pendingLoads;  // 正在加载的 key 与等待它的回调
+    quint64 lastPendingToken = 0;
     qint64 diskCacheMaxSize;
     qint64 minFreeSpace = 100 * 1024 * 1024;
     QTimer* m_diskMonitorTimer = nullptr;
@@ -5,126 +5,354 @@
 //
 
 #include "EXImageRequest.h"
+#include <QMutexLocker>
+#include <algorithm>
+#include <utility>
 
 EXImageRequest::EXImageRequest(const QUrl& url,
-                             std::function<void (const QPixmap&, bool)> callback,
+                             Callback callback,
                              ImageLoader::Priority priority,
                              const QSize& thumbnailSize,
-                             const EXImageProcessingChain& processingChain)
+                             const EXImageProcessingChain& processingChain,
+                             ProgressiveCallback progressiveCallback)
     : m_url(url),
-    m_callback(callback),
     m_priority(priority),
-    m_thumbnailSize(thumbnailSize),
-    m_processingChain(processingChain),
+    m_partialGate(std::make_shared<PartialDecodeGate>()),
     m_cancelled(false)
 {
+    Variant variant{ thumbnailSize, processingChain, processingChain.chainIdentifier(), { callback }, {} };
+    if (progressiveCallback) {
+        variant.progressiveCallbacks.append(progressiveCallback);
+    }
+    m_variants.append(variant);
     m_requestId = generateRequestId();
+    // 由调度器在 finished 之后 deleteLater()，线程池不能在 run() 之后自动删除
+    setAutoDelete(false);
 }
 
 EXImageRequest::~EXImageRequest()
 {
     cancel();
+    notify(takeVariants(), QPixmap());
 }
 
-void EXImageRequest::run()
+bool EXImageRequest::merge(EXImageRequest* other)
 {
-    if (m_cancelled) {
-        emit finished();
-        return;
+    QMutexLocker locker(&m_mutex);
+    if (m_started || other->m_url != m_url) return false;
+
+    // `other` 的变体与回调全部移到这个请求中，之后删除 `other` 不会再调用它们
+    const QList<Variant> variants = other->takeVariants();
+    for (const Variant& variant : variants) {
+        auto it = std::find_if(m_variants.begin(), m_variants.end(), [&variant](const Variant& existing) {
+            return existing.thumbnailSize == variant.thumbnailSize && existing.processingId == variant.processingId;
+        });
+        if (it != m_variants.end()) {
+            it->callbacks.append(variant.callbacks);
+            it->progressiveCallbacks.append(variant.progressiveCallbacks);
+        } else {
+            m_variants.append(variant);
+        }
     }
+    return true;
+}
 
-    QPixmap result;
-    bool fromNetwork = false;
+void EXImageRequest::run()
+{
+    // 取走变体之后不能再 merge()，新的加载会排队等待下一个请求
+    const QList<Variant> variants = takeVariants();
+    closePartialDecodeGate();
 
-    if (m_url.isLocalFile()) {
-        result = QPixmap(m_url.toLocalFile());
-    } else {
-        result = downloadImage();
-        fromNetwork = !result.isNull();
+    if (m_partialDownloadCallback && m_partialResult) {
+        m_partialDownloadCallback(*m_partialResult);
     }
 
-    if (m_cancelled) {
-        emit finished();
-        return;
+    std::shared_ptr<EXStreamingImageDecoder> decoder;
+    {
+        QMutexLocker locker(&m_mutex);
+        decoder = std::exchange(m_decoder, nullptr);
     }
 
-    if (!result.isNull()) {
-        if (!m_thumbnailSize.isEmpty() || !m_processingChain.isEmpty()) {
-            result = processImage(result);
+    QPixmap source;
+    if (!m_cancelled) {
+        if (m_url.isLocalFile()) {
+            source = QPixmap(m_url.toLocalFile());
+        } else if (!m_data.isEmpty()) {
+            // 边下载边解码已经得到完整的图片时直接使用；解码器还没开始、数据不完整或解码失败时解码完整的数据
+            QImage image = decoder ? decoder->takeResult() : QImage();
+            if (image.isNull()) {
+                image = QImage::fromData(m_data);
+            }
+            source = QPixmap::fromImage(image);
         }
+    }
+
+    // 原始数据只保存一次，先于变体的回调: 变体按保存后的缓存信息保存处理后的图片
+    if (m_downloadCallback && !source.isNull() && !m_cancelled && !m_url.isLocalFile()) {
+        m_downloadCallback(m_data, m_response);
+    }
 
-        if (!m_cancelled) {
-            m_callback(result, fromNetwork);
+    // 解码一次，每个变体分别处理
+    QList<QPixmap> results;
+    for (const Variant& variant : variants) {
+        QPixmap result;
+        if (!source.isNull() && !m_cancelled) {
+            result = variant.processingChain.isEmpty() ? source : variant.processingChain.apply(source);
         }
+        results.append(result);
     }
 
+    // 与不完整的图片走同一个投递队列: 正在回调的不完整的图片结束之后才回调最终结果
+    deliver(m_partialGate, [variants, results, response = m_response, variantCallback = m_variantCallback]() {
+        for (int i = 0; i < variants.size(); ++i) {
+            const Variant& variant = variants[i];
+            if (variantCallback && !results[i].isNull()) {
+                variantCallback(variant.thumbnailSize, variant.processingId, variant.processingChain, results[i], response);
+            }
+            for (const Callback& callback : variant.callbacks) {
+                callback(results[i], response);
+            }
+        }
+    });
+
     emit finished();
 }
 
+EXNetworkEngine::RawHeaders EXImageRequest::conditionalHeaders() const
+{
+    EXNetworkEngine::RawHeaders headers;
+    if (!m_revalidation.cachedData.isEmpty()) {
+        if (!m_revalidation.eTag.isEmpty()) {
+            headers.append({ "If-None-Match", m_revalidation.eTag });
+        }
+        if (!m_revalidation.lastModified.isEmpty()) {
+            headers.append({ "If-Modified-Since", m_revalidation.lastModified });
+        }
+    } else if (!m_resume.data.isEmpty() && !m_resume.validator.isEmpty()) {
+        // Range 按传输的字节计算；不接受压缩，QNetworkAccessManager 也就不会自动解压，两段数据才能直接拼接
+        headers.append({ "Range", "bytes=" + QByteArray::number(m_resume.data.size()) + "-" });
+        headers.append({ "If-Range", m_resume.validator });
+        headers.append({ "Accept-Encoding", "identity" });
+    }
+    return headers;
+}
+
+bool EXImageRequest::takeRangeFallback(const EXNetworkResponse& response)
+{
+    if (m_resume.data.isEmpty() || !m_revalidation.cachedData.isEmpty()) return false;
+
+    // Content-Range: bytes <first>-<last>/<complete-length>
+    const QByteArray range = response.contentRange.trimmed();
+    const bool matches = range.startsWith("bytes ")
+                         && range.mid(6, range.indexOf('-') - 6).toLongLong() == m_resume.data.size();
+    if (response.statusCode == 416 || (response.statusCode == 206 && !matches)) {
+        m_resume = PartialDownload();
+        return true;
+    }
+    return false;
+}
+
+void EXImageRequest::setDownloadedData(const QByteArray& data,
+                                       QNetworkReply::NetworkError error,
+                                       const EXNetworkResponse& response)
+{
+    m_response = response;
+
+    // 边下载边解码: 补上最后收到的数据，告诉解码器数据已经结束
+    std::shared_ptr<EXStreamingImageDecoder> decoder;
+    {
+        QMutexLocker locker(&m_mutex);
+        decoder = m_decoder;
+    }
+    if (decoder) {
+        decoder->append(data.mid(m_streamedBytes));
+        m_streamedBytes = data.size();
+        decoder->finish(error == QNetworkReply::NoError && response.statusCode != 304);
+    }
+
+    // 206: 服务器从已收到的部分之后继续；200: 不支持 Range 或内容变了，完整的新内容
+    const bool resumed = response.statusCode == 206 && !m_resume.data.isEmpty();
+    const QByteArray received = resumed ? m_resume.data + data : data;
+
+    if (response.statusCode == 304) {
+        m_data = m_revalidation.cachedData;
+    } else {
+        m_data = error == QNetworkReply::NoError ? received : QByteArray();
+    }
+    m_revalidation.cachedData.clear();
+
+    if (error == QNetworkReply::NoError) {
+        if (m_resumeRequested) {
+            m_partialResult = PartialDownload();
+        }
+    } else if (resumed || response.statusCode == 200) {
+        // 收到内容之后中断: 记下已收到的数据与验证器；只有强验证器能用于 If-Range，压缩传输的数据与 Range 的字节对不上。
+        // 不能继续时也要报告，之前保存的部分已经作废
+        PartialDownload partial;
+        if (!received.isEmpty()
+            && (response.contentEncoding.isEmpty() || response.contentEncoding == "identity")
+            && response.acceptRanges.trimmed() != "none") {
+            partial.validator = resumed ? m_resume.validator
+                : (!response.eTag.isEmpty() && !response.eTag.startsWith("W/") ? response.eTag : response.lastModified);
+            partial.data = partial.validator.isEmpty() ? QByteArray() : received;
+        }
+        if (!partial.data.isEmpty() || m_resumeRequested) {
+            m_partialResult = partial;
+        }
+    }
+    m_resume = PartialDownload();
+}
+
 void EXImageRequest::cancel()
 {
     m_cancelled = true;
+    closePartialDecodeGate();
+
+    std::shared_ptr<EXStreamingImageDecoder> decoder;
+    {
+        QMutexLocker locker(&m_mutex);
+        decoder = m_decoder;
+    }
+    if (decoder) {
+        decoder->abort();
+    }
 }
 
-void EXImageRequest::reportProgress(int percent)
+std::function<void()> EXImageRequest::streamPartialData(const QByteArray& data, qint64 interval)
 {
-    if (!m_cancelled) {
-        emit progress(percent);
+    // 已经在边下载边解码: 只交出新收到的数据
+    std::shared_ptr<EXStreamingImageDecoder> decoder;
+    {
+        QMutexLocker locker(&m_mutex);
+        decoder = m_decoder;
+    }
+    if (decoder) {
+        decoder->append(data.mid(m_streamedBytes));
+        m_streamedBytes = data.size();
+        return nullptr;
     }
+
+    // 只对 JPEG 边下载边解码: 基线 JPEG 按行解码，已解码的行就是不完整的图片；
+    // Qt 的 PNG、WebP 等解码器读完全部数据之前没有可以显示的内容。
+    // 继续中断的下载、验证过期的缓存时收到的不是完整的文件，也不边下载边解码
+    if (m_cancelled || interval <= 0 || !data.startsWith("\xFF\xD8")) return nullptr;
+    if (!m_resume.data.isEmpty() || !m_revalidation.cachedData.isEmpty()) return nullptr;
+
+    QList<std::pair<EXImageProcessingChain, QList<ProgressiveCallback>>> targets;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_started) return nullptr;
+        for (const Variant& variant : m_variants) {
+            if (!variant.progressiveCallbacks.isEmpty()) {
+                targets.append({ variant.processingChain, variant.progressiveCallbacks });
+            }
+        }
+    }
+    if (targets.isEmpty()) return nullptr;
+
+    // 不完整的图片在解码线程中处理，回调时不持有锁，回调中可以取消请求；
+    // run() 关闭之后才投递的、比已投递的旧的不完整的图片都丢掉
+    auto frameHandler = [gate = m_partialGate, targets](const QImage& image) {
+        QList<std::pair<QPixmap, QList<ProgressiveCallback>>> pixmaps;
+        const QPixmap source = QPixmap::fromImage(image);
+        for (const auto& [processingChain, callbacks] : targets) {
+            if (gate->isClosed()) break;
+            pixmaps.append({ processingChain.isEmpty() ? source : processingChain.apply(source), callbacks });
+        }
+
+        quint64 sequence = 0;
+        {
+            QMutexLocker locker(&gate->mutex);
+            if (!gate->closed && !pixmaps.isEmpty()) {
+                sequence = ++gate->sequence;
+            }
+        }
+        if (sequence == 0) return;
+
+        deliver(gate, [gate, sequence, pixmaps]() {
+            {
+                QMutexLocker locker(&gate->mutex);
+                if (gate->closed || sequence <= gate->deliveredSequence) return;
+                gate->deliveredSequence = sequence;
+            }
+            for (const auto& [pixmap, callbacks] : pixmaps) {
+                for (const ProgressiveCallback& callback : callbacks) {
+                    callback(pixmap);
+                }
+            }
+        });
+    };
+
+    decoder = std::make_shared<EXStreamingImageDecoder>(interval, std::move(frameHandler));
+    decoder->append(data);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_started) return nullptr;
+        m_decoder = decoder;
+    }
+    m_streamedBytes = data.size();
+    if (m_cancelled) {
+        decoder->abort();
+    }
+    return [decoder]() { decoder->decode(); };
 }
 
-QPixmap EXImageRequest::downloadImage()
+void EXImageRequest::closePartialDecodeGate()
 {
-    QNetworkAccessManager manager;
-    QEventLoop loop;
-    QNetworkReply *reply = manager.get(QNetworkRequest(m_url));
+    QMutexLocker locker(&m_partialGate->mutex);
+    m_partialGate->closed = true;
+}
 
-    connect(reply, &QNetworkReply::downloadProgress,
-            [this](qint64 received, qint64 total) {
-                if (total > 0) {
-                    int percent = static_cast<int>(received * 100 / total);
-                    reportProgress(percent);
-                }
-            });
+bool EXImageRequest::PartialDecodeGate::isClosed()
+{
+    QMutexLocker locker(&mutex);
+    return closed;
+}
 
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
+void EXImageRequest::deliver(const std::shared_ptr<PartialDecodeGate>& gate, std::function<void()> delivery)
+{
+    // 已经有线程在投递时排在它后面，由它按顺序执行；回调中再投递(同一个线程)也只是排队，不会重入
+    QMutexLocker locker(&gate->mutex);
+    gate->deliveries.append(std::move(delivery));
+    if (gate->delivering) return;
 
-    if (m_cancelled || reply->error() != QNetworkReply::NoError) {
-        reply->deleteLater();
-        return QPixmap();
+    gate->delivering = true;
+    while (!gate->deliveries.isEmpty()) {
+        const std::function<void()> next = gate->deliveries.takeFirst();
+        locker.unlock();
+        next();
+        locker.relock();
     }
+    gate->delivering = false;
+}
 
-    QByteArray data = reply->readAll();
-    QImage image;
-    image.loadFromData(data);
-    QPixmap pixmap = QPixmap::fromImage(image);
+void EXImageRequest::reportProgress(int percent)
+{
+    if (!m_cancelled) {
+        emit progress(percent);
+    }
+}
 
-    reply->deleteLater();
-    return pixmap;
+QList<EXImageRequest::Variant> EXImageRequest::takeVariants()
+{
+    QMutexLocker locker(&m_mutex);
+    m_started = true;
+    return std::exchange(m_variants, {});
 }
 
-QPixmap EXImageRequest::processImage(QPixmap pixmap) const
+void EXImageRequest::notify(const QList<Variant>& variants, const QPixmap& pixmap)
 {
-    if (pixmap.isNull()) return pixmap;
-    return m_processingChain.apply(pixmap);
+    for (const Variant& variant : variants) {
+        for (const Callback& callback : variant.callbacks) {
+            callback(pixmap, EXNetworkResponse());
+        }
+    }
 }
 
 QString EXImageRequest::generateRequestId() const
 {
+    // 按 URL 区分请求，同一个 URL 的不同变体并入同一个请求
     QCryptographicHash hash(QCryptographicHash::Sha1);
     hash.addData(m_url.toString().toUtf8());
-    hash.addData(m_thumbnailSize.isEmpty() ? "" :
-                     QByteArray::number(m_thumbnailSize.width()) +
-                         QByteArray::number(m_thumbnailSize.height()));
-    hash.addData(m_processingChain.chainIdentifier().toUtf8());
-
     return hash.result().toHex();
 }
-
-bool EXImageRequest::isSameRequest(const EXImageRequest* other) const
-{
-    return m_url == other->m_url &&
-           m_thumbnailSize == other->m_thumbnailSize &&
-           m_processingChain.chainIdentifier() == other->m_processingChain.chainIdentifier();
-}
@@ -7,37 +7,148 @@
 #pragma once
 
 #include "EXImageProcessing.h"
+#include "EXNetworkEngine.h"
+#include "EXStreamingImageDecoder.h"
 #include <QRunnable>
 #include <QObject>
 #include <QUrl>
 #include <QSize>
 #include <QPixmap>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QEventLoop>
-#include <QBuffer>
+#include <QByteArray>
 #include <QCryptographicHash>
+#include <QList>
+#include <QMutex>
 #include <atomic>
+#include <memory>
+#include <optional>
+#include <utility>
 
+/**
+ 一个 URL 的加载: 网络图片由 EXNetworkEngine 下载，下载完成后通过 setDownloadedData() 交给请求，
+ 再放入线程池执行 run()；run() 只做解码与处理，不访问网络。
+
+ 同一个 URL 的多个加载(不同的缩略图尺寸、处理链)通过 merge() 并入同一个请求，成为它的变体(variant)，
+ 共用一次下载与一次解码，再分别处理；同一个变体的多个回调共用处理结果。
+
+ 下载过程中可以用 streamPartialData() 边下载边解码(EXStreamingImageDecoder)，把不完整的图片交给 progressive 回调，
+ 大图在慢速网络上先显示已收到的部分；下载结束时解码也随之结束，最终结果直接使用同一个解码器的图片，
+ 一定在所有不完整的图片之后回调。
+
+ 磁盘缓存中的原始数据过期时，用 setRevalidation() 带上验证器发条件请求；服务器返回 304 时解码缓存的数据。
+ 之前中断的下载用 setPartialDownload() 带上已收到的部分，以 Range/If-Range 请求剩下的内容。
+ */
 class EXImageRequest : public QObject, public QRunnable
 {
     Q_OBJECT
 public:
+    /**
+     `callback` 的第二个参数是响应信息，每个变体都有；读取本地文件时为空。
+     每个回调只调用一次: 失败、取消时 QPixmap 为空。
+     */
+    using Callback = std::function<void(const QPixmap&, const EXNetworkResponse&)>;
+    // 不完整的图片，已经过变体的处理链；可能调用零次或多次，都在最终的 Callback 之前
+    using ProgressiveCallback = std::function<void(const QPixmap&)>;
+
     EXImageRequest(const QUrl& url,
-                  std::function<void(const QPixmap&, bool)> callback,
+                  Callback callback,
                   ImageLoader::Priority priority,
                   const QSize& thumbnailSize,
-                  const EXImageProcessingChain& processingChain);
+                  const EXImageProcessingChain& processingChain,
+                  ProgressiveCallback progressiveCallback = nullptr);
 
+    // 还没有调用的回调以空的 QPixmap 调用，例如在队列中被取消、删除的请求
     ~EXImageRequest();
 
+    // 把同一个 URL 的 `other` 的变体与回调并入这个请求；已经开始解码时返回 false，`other` 不变
+    bool merge(EXImageRequest* other);
+
     void run() override;
     void cancel();
+    bool isCancelled() const { return m_cancelled; }
 
     ImageLoader::Priority priority() const { return m_priority; }
+    void setPriority(ImageLoader::Priority priority) { m_priority = priority; }
     QString requestId() const { return m_requestId; }
+    const QUrl& url() const { return m_url; }
+
+    // 过期的缓存: 验证器与缓存的原始数据
+    struct Revalidation
+    {
+        QByteArray eTag;
+        QByteArray lastModified;
+        QByteArray cachedData;
+    };
+
+    // 在 enqueueRequest() 之前调用
+    void setRevalidation(const Revalidation& revalidation) { m_revalidation = revalidation; }
+    // 中断的下载: 已收到的部分与 If-Range 用的验证器(强 ETag 或 Last-Modified)
+    struct PartialDownload
+    {
+        QByteArray validator;
+        QByteArray data;
+    };
+    /**
+     下载结束时(run() 之前)调用: 中断时是已收到的全部数据，可以保存下来之后继续；
+     完整下载或内容已经变了时 `data` 为空，之前保存的部分应删除。
+     没有收到新的内容(连接失败、服务器错误、取消)时不调用，之前保存的部分仍然有效。
+     */
+    using PartialDownloadCallback = std::function<void(const PartialDownload&)>;
+
+    // 在 enqueueRequest() 之前调用；有过期的缓存(setRevalidation())时不使用
+    void setPartialDownload(const PartialDownload& partial)
+    {
+        m_resume = partial;
+        m_resumeRequested = !partial.data.isEmpty();
+    }
+    void setPartialDownloadCallback(PartialDownloadCallback callback) { m_partialDownloadCallback = std::move(callback); }
+
+    /**
+     下载的原始数据(未解码、未处理，304 时是缓存的数据)能解码时，在变体的回调之前调用一次，
+     与变体的处理结果、回调的个数无关；取消、失败与读取本地文件时不调用。
+     并入的请求的 DownloadCallback 不会被调用，一次下载只保存一次
+     */
+    using DownloadCallback = std::function<void(const QByteArray&, const EXNetworkResponse&)>;
+    void setDownloadCallback(DownloadCallback callback) { m_downloadCallback = std::move(callback); }
 
-    bool isSameRequest(const EXImageRequest* other) const;
+    /**
+     每个处理成功的变体调用一次，在它的回调之前，用于缓存处理结果；与并入的回调的个数无关。
+     并入的请求的 VariantCallback 不会被调用: 合并只增加回调，不重复缓存
+     */
+    using VariantCallback = std::function<void(const QSize& thumbnailSize,
+                                               const QString& processingId,
+                                               const EXImageProcessingChain& processingChain,
+                                               const QPixmap& result,
+                                               const EXNetworkResponse& response)>;
+    void setVariantCallback(VariantCallback callback) { m_variantCallback = std::move(callback); }
+
+    /**
+     请求头: 有过期的缓存时是条件请求头 If-None-Match、If-Modified-Since；
+     有中断的下载时是 Range 与 If-Range(内容变了时服务器返回完整的 200)；都没有时为空
+     */
+    EXNetworkEngine::RawHeaders conditionalHeaders() const;
+
+    /**
+     服务器不接受 Range(416，或 206 的 Content-Range 与已收到的部分对不上)时返回 true，
+     并丢掉已收到的部分，调用方应重新发起完整的下载
+     */
+    bool takeRangeFallback(const EXNetworkResponse& response);
+
+    // 网络图片下载结束后、run() 之前调用；304 时改用缓存的数据，206 时拼在已收到的部分之后
+    void setDownloadedData(const QByteArray& data,
+                           QNetworkReply::NetworkError error,
+                           const EXNetworkResponse& response);
+
+    // EXNetworkEngine 中的下载编号，0 表示不需要下载或还没开始
+    quint64 networkTaskId() const { return m_networkTaskId.load(); }
+    void setNetworkTaskId(quint64 taskId) { m_networkTaskId = taskId; }
+
+    /**
+     下载过程中(网络线程)以目前收到的全部数据调用。第一次调用时，如果是 JPEG 并且有 progressive 回调，
+     创建边下载边解码的解码器，返回在线程池中执行的解码任务: 任务一直执行到下载结束，解码器每多读取 `interval` 字节、
+     追上已收到的数据时交出一次不完整的图片。之后的调用只把新收到的数据交给解码器，返回空。
+     任务不访问请求本身，请求删除后仍可安全执行。
+     */
+    std::function<void()> streamPartialData(const QByteArray& data, qint64 interval);
 
     void reportProgress(int percent);
 
@@ -46,15 +157,56 @@ signals:
     void progress(int percent);
 
 private:
-    QPixmap downloadImage();
-    QPixmap processImage(QPixmap pixmap) const;
+    struct Variant
+    {
+        QSize thumbnailSize;
+        EXImageProcessingChain processingChain;
+        QString processingId;
+        QList<Callback> callbacks;
+        QList<ProgressiveCallback> progressiveCallbacks;
+    };
+
+    /**
+     部分解码任务与 run() 之间的同步: run() 关闭之后不再调用 progressive 回调。
+     不完整的图片与最终结果按顺序投递，调用回调时不持有 `mutex`
+     */
+    struct PartialDecodeGate
+    {
+        QMutex mutex;
+        bool closed = false;
+        quint64 sequence = 0;               // 最后一个排队的不完整的图片的序号
+        quint64 deliveredSequence = 0;      // 最后一个已回调的不完整的图片的序号
+        QList<std::function<void()>> deliveries;
+        bool delivering = false;            // 有线程正在执行 `deliveries`
+
+        bool isClosed();
+    };
+
+    void closePartialDecodeGate();
+    static void deliver(const std::shared_ptr<PartialDecodeGate>& gate, std::function<void()> delivery);
+
+    QList<Variant> takeVariants();
+    static void notify(const QList<Variant>& variants, const QPixmap& pixmap);
     QString generateRequestId() const;
 
     QUrl m_url;
-    std::function<void(const QPixmap&, bool)> m_callback;
     ImageLoader::Priority m_priority;
-    QSize m_thumbnailSize;
-    EXImageProcessingChain m_processingChain;
+    QMutex m_mutex;                 // 保护 m_variants、m_started 与 m_decoder
+    QList<Variant> m_variants;
+    bool m_started = false;         // run() 已取走变体，之后不能再 merge()
     QString m_requestId;
+    QByteArray m_data;
+    EXNetworkResponse m_response;
+    Revalidation m_revalidation;
+    PartialDownload m_resume;
+    bool m_resumeRequested = false;                 // 用过 setPartialDownload()，磁盘缓存中有之前保存的部分
+    std::optional<PartialDownload> m_partialResult; // 下载结束时交给 m_partialDownloadCallback
+    PartialDownloadCallback m_partialDownloadCallback;
+    DownloadCallback m_downloadCallback;
+    VariantCallback m_variantCallback;
+    std::atomic<quint64> m_networkTaskId{ 0 };
+    std::shared_ptr<PartialDecodeGate> m_partialGate;
+    std::shared_ptr<EXStreamingImageDecoder> m_decoder; // 边下载边解码，没有时为空
+    qint64 m_streamedBytes = 0;         // 已交给 m_decoder 的字节数，只在网络线程中访问
     std::atomic<bool> m_cancelled;
 };
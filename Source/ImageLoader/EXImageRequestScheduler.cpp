@@ -30,6 +30,7 @@ EXImageRequestScheduler::~EXImageRequestScheduler()
 {
     cancelAll();
     m_threadPool.waitForDone();
+    m_decodePool.waitForDone();
 }
 
 void EXImageRequestScheduler::initializeThreadPool()
@@ -45,6 +46,7 @@ void EXImageRequestScheduler::initializeThreadPool()
 
     maxThreads = qMax(2, maxThreads);
     m_threadPool.setMaxThreadCount(maxThreads);
+    m_decodePool.setMaxThreadCount(maxThreads);
     qDebug() << "EXImageRequestScheduler initialized with max threads:" << maxThreads;
 }
 
@@ -52,6 +54,30 @@ void EXImageRequestScheduler::enqueueRequest(EXImageRequest* request)
 {
     QWriteLocker locker(&m_lock);
 
+    // 同一个 URL 正在下载、或还没开始解码: 并入已有的请求，共用下载与解码，回调由它调用
+    if (EXImageRequest* active = m_activeRequests.value(request->requestId())) {
+        if (active->merge(request)) {
+            delete request;
+            return;
+        }
+    }
+
+    for (auto& queue : m_requestQueues) {
+        for (auto it = queue.begin(); it != queue.end(); ++it) {
+            EXImageRequest* queued = *it;
+            if (queued->requestId() != request->requestId() || !queued->merge(request)) continue;
+
+            // 按并入的请求中最高的优先级排队
+            if (request->priority() > queued->priority()) {
+                queue.erase(it);
+                queued->setPriority(request->priority());
+                m_requestQueues[queued->priority()].enqueue(queued);
+            }
+            delete request;
+            return;
+        }
+    }
+
     if (m_totalQueued >= m_config->queueCapacity()) {
         qWarning() << "Request queue overflow! Max capacity:" << m_config->queueCapacity();
         delete request;
@@ -60,14 +86,6 @@ void EXImageRequestScheduler::enqueueRequest(EXImageRequest* request)
     }
 
     auto& queue = m_requestQueues[request->priority()];
-    for (EXImageRequest* existing : queue) {
-        if (existing->isSameRequest(request)) {
-            qDebug() << "Duplicate request skipped:" << request->requestId();
-            delete request;
-            return;
-        }
-    }
-
     queue.enqueue(request);
     m_totalQueued++;
 
@@ -80,6 +98,9 @@ void EXImageRequestScheduler::cancelRequest(const QString& requestId)
 
     if (EXImageRequest* request = m_activeRequests.value(requestId)) {
         request->cancel();
+        if (const quint64 taskId = request->networkTaskId()) {
+            m_networkEngine.cancel(taskId);
+        }
         m_activeRequests.remove(requestId);
         m_currentConcurrent = m_activeRequests.size();
         emit requestCancelled(requestId);
@@ -107,6 +128,7 @@ void EXImageRequestScheduler::cancelAll()
     for (EXImageRequest* request : m_activeRequests) {
         request->cancel();
     }
+    m_networkEngine.cancelAll();
     m_activeRequests.clear();
     m_currentConcurrent = 0;
     emit concurrentCountChanged(0);
@@ -133,46 +155,111 @@ int EXImageRequestScheduler::queuedRequestCount() const
 
 void EXImageRequestScheduler::processNextRequest()
 {
-    // QWriteLocker locker(&m_lock);
+    // enqueueRequest() 在其他线程中并入正在进行的请求，队列与 m_activeRequests 的修改都要加锁；
+    // 信号在解锁之后发出，连接的槽可以再调用调度器
+    EXImageRequest* request = nullptr;
+    int concurrent = 0;
+    bool hasMore = false;
+    {
+        QWriteLocker locker(&m_lock);
+        if (m_currentConcurrent >= m_threadPool.maxThreadCount()) {
+            return;
+        }
 
-    if (m_currentConcurrent >= m_threadPool.maxThreadCount()) {
-        return;
+        for (int p = static_cast<int>(ImageLoader::Priority::VeryHigh);
+             p >= static_cast<int>(ImageLoader::Priority::VeryLow); --p) {
+            auto& queue = m_requestQueues[static_cast<ImageLoader::Priority>(p)];
+            if (!queue.isEmpty()) {
+                request = queue.dequeue();
+                m_totalQueued--;
+                break;
+            }
+        }
+        if (!request) return;
+
+        m_activeRequests.insert(request->requestId(), request);
+        m_currentConcurrent = m_activeRequests.size();
+        concurrent = m_currentConcurrent;
+        hasMore = m_currentConcurrent < m_threadPool.maxThreadCount() && m_totalQueued > 0;
     }
 
-    for (int p = static_cast<int>(ImageLoader::Priority::VeryHigh);
-         p >= static_cast<int>(ImageLoader::Priority::VeryLow); --p) {
+    connect(request, &EXImageRequest::finished, this, [this, request] {
+        int concurrent = 0;
+        {
+            QWriteLocker locker(&m_lock);
+            // 同一个 URL 的新请求可能已经开始，只移除自己
+            if (m_activeRequests.value(request->requestId()) == request) {
+                m_activeRequests.remove(request->requestId());
+            }
+            m_currentConcurrent = m_activeRequests.size();
+            concurrent = m_currentConcurrent;
+        }
+        emit requestFinished(request->requestId());
+        emit concurrentCountChanged(concurrent);
+        request->deleteLater();
+        processNextRequest();
+    });
 
-        auto priority = static_cast<ImageLoader::Priority>(p);
-        auto& queue = m_requestQueues[priority];
+    startRequest(request);
+    emit requestStarted(request->requestId());
+    emit concurrentCountChanged(concurrent);
 
-        if (!queue.isEmpty()) {
-            EXImageRequest* request = queue.dequeue();
-            m_totalQueued--;
+    if (hasMore) {
+        QMetaObject::invokeMethod(this, "processNextRequest", Qt::QueuedConnection);
+    }
+}
 
-            m_activeRequests.insert(request->requestId(), request);
-            m_currentConcurrent = m_activeRequests.size();
+void EXImageRequestScheduler::startRequest(EXImageRequest* request)
+{
+    if (request->url().isLocalFile()) {
+        m_threadPool.start(request);
+        return;
+    }
 
-            connect(request, &EXImageRequest::finished, this, [this, request] {
-                // QWriteLocker lock(&m_lock);
-                m_activeRequests.remove(request->requestId());
-                m_currentConcurrent = m_activeRequests.size();
-                emit requestFinished(request->requestId());
-                emit concurrentCountChanged(m_currentConcurrent);
-                request->deleteLater();
-                processNextRequest();
-            });
-
-            m_threadPool.start(request);
-            emit requestStarted(request->requestId());
-            emit concurrentCountChanged(m_currentConcurrent);
-
-            if (m_currentConcurrent < m_threadPool.maxThreadCount()) {
-                QMetaObject::invokeMethod(this, "processNextRequest", Qt::QueuedConnection);
-            }
+    // 重新下载之前已被取消
+    if (request->isCancelled()) {
+        request->run();
+        return;
+    }
 
-            return;
-        }
+    // 边下载边解码，不完整的图片交给 progressive 回调。解码任务在下载期间一直等待数据，
+    // 放在单独的线程池中，不占用最终解码的线程；run() 时还没开始的任务直接放弃
+    EXNetworkEngine::PartialDataHandler partialData;
+    if (const int interval = m_config->progressiveDecodeInterval(); interval > 0) {
+        partialData = [this, request, interval](const QByteArray& data, qint64) {
+            if (auto task = request->streamPartialData(data, interval)) {
+                m_decodePool.start(std::move(task));
+            }
+        };
     }
+
+    // 下载完成后在网络线程中回调，只把数据交给线程池解码；取消的请求不再解码，直接结束
+    const quint64 taskId = m_networkEngine.get(request->url(), request->priority(),
+        [request](qint64 received, qint64 total) {
+            if (total > 0) {
+                request->reportProgress(static_cast<int>(received * 100 / total));
+            }
+        },
+        [this, request](const QByteArray& data, QNetworkReply::NetworkError error, const EXNetworkResponse& response) {
+            // 服务器不接受继续下载: 回到调度器线程重新完整下载一次
+            if (request->takeRangeFallback(response)) {
+                QMetaObject::invokeMethod(this, [this, request]() {
+                    startRequest(request);
+                }, Qt::QueuedConnection);
+                return;
+            }
+
+            request->setDownloadedData(data, error, response);
+            if (error == QNetworkReply::OperationCanceledError) {
+                request->cancel();
+                request->run();
+            } else {
+                m_threadPool.start(request);
+            }
+        },
+        partialData,
+        request->conditionalHeaders());
+    request->setNetworkTaskId(taskId);
 }
 
 void EXImageRequestScheduler::adjustThreadPool()
@@ -9,6 +9,7 @@
 #include "EXImageLoaderGlobal.h"
 #include "EXImageRequest.h"
 #include "EXImageLoaderConfiguration.h"
+#include "EXNetworkEngine.h"
 #include <QObject>
 #include <QQueue>
 #include <QHash>
@@ -48,14 +49,17 @@ private slots:
 
 private:
     void initializeThreadPool();
+    void startRequest(EXImageRequest* request);
     double calculateSystemLoad() const;
 
     EXImageLoaderConfiguration* m_config;
-    QThreadPool m_threadPool;
+    QThreadPool m_threadPool;           // 只做解码与处理；下载在 m_networkEngine 的网络线程中进行
+    QThreadPool m_decodePool;           // 边下载边解码，任务在下载期间等待数据
     QHash<ImageLoader::Priority, QQueue<EXImageRequest*>> m_requestQueues;
     QHash<QString, EXImageRequest*> m_activeRequests;
     mutable QReadWriteLock m_lock;
     QTimer* m_adjustTimer = nullptr;
     int m_currentConcurrent = 0;
     int m_totalQueued = 0;
+    EXNetworkEngine m_networkEngine;    // 在 m_threadPool 之前析构，取消的下载完成回调时线程池仍然存在
 };
@@ -0,0 +1,136 @@
+//
+//  EXNetworkEngine.cpp
+//
+//  Created by evanxlh on 2025/6/29.
+//
+
+#include "EXNetworkEngine.h"
+#include <QNetworkRequest>
+#include <memory>
+
+EXNetworkEngine::EXNetworkEngine()
+    : m_manager(new QNetworkAccessManager())
+{
+    // QNetworkAccessManager 在使用之前移到网络线程，之后只在网络线程中访问
+    m_thread.setObjectName(QStringLiteral("EXNetworkEngine"));
+    m_manager->moveToThread(&m_thread);
+    QObject::connect(&m_thread, &QThread::finished, m_manager, &QObject::deleteLater);
+    m_thread.start();
+}
+
+EXNetworkEngine::~EXNetworkEngine()
+{
+    // 等网络线程取消所有下载、调用完回调，再结束线程
+    QMetaObject::invokeMethod(m_manager, [this]() {
+        _abortAll();
+    }, Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+}
+
+quint64 EXNetworkEngine::get(const QUrl& url,
+                             ImageLoader::Priority priority,
+                             ProgressHandler progress,
+                             CompletionHandler completion,
+                             PartialDataHandler partialData,
+                             const RawHeaders& headers)
+{
+    const quint64 taskId = m_nextTaskId.fetch_add(1, std::memory_order_relaxed);
+    QMetaObject::invokeMethod(m_manager, [this, taskId, url, priority,
+                                          progress = std::move(progress),
+                                          completion = std::move(completion),
+                                          partialData = std::move(partialData), headers]() {
+        _start(taskId, url, priority, progress, completion, partialData, headers);
+    }, Qt::QueuedConnection);
+    return taskId;
+}
+
+void EXNetworkEngine::cancel(quint64 taskId)
+{
+    // 与 get() 投递到同一个事件队列，一定在对应的 _start() 之后执行
+    QMetaObject::invokeMethod(m_manager, [this, taskId]() {
+        if (QNetworkReply* reply = m_replies.value(taskId)) {
+            reply->abort();
+        }
+    }, Qt::QueuedConnection);
+}
+
+void EXNetworkEngine::cancelAll()
+{
+    QMetaObject::invokeMethod(m_manager, [this]() {
+        _abortAll();
+    }, Qt::QueuedConnection);
+}
+
+void EXNetworkEngine::_start(quint64 taskId,
+                             const QUrl& url,
+                             ImageLoader::Priority priority,
+                             const ProgressHandler& progress,
+                             const CompletionHandler& completion,
+                             const PartialDataHandler& partialData,
+                             const RawHeaders& headers)
+{
+    QNetworkRequest request(url);
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+    if (priority >= ImageLoader::Priority::High) {
+        request.setPriority(QNetworkRequest::HighPriority);
+    } else if (priority <= ImageLoader::Priority::Low) {
+        request.setPriority(QNetworkRequest::LowPriority);
+    }
+    for (const auto& [name, value] : headers) {
+        request.setRawHeader(name, value);
+    }
+
+    QNetworkReply* reply = m_manager->get(request);
+    m_replies.insert(taskId, reply);
+
+    if (progress) {
+        QObject::connect(reply, &QNetworkReply::downloadProgress, reply, [progress](qint64 received, qint64 total) {
+            progress(received, total);
+        });
+    }
+
+    // 边收边从 reply 中取出，累积在 `received` 中: 中断时已收到的部分不会随 reply 丢失
+    auto received = std::make_shared<QByteArray>();
+    QObject::connect(reply, &QNetworkReply::readyRead, reply, [reply, received, partialData]() {
+        received->append(reply->readAll());
+        if (partialData) {
+            const QVariant length = reply->header(QNetworkRequest::ContentLengthHeader);
+            partialData(*received, length.isValid() ? length.toLongLong() : -1);
+        }
+    });
+
+    // abort() 时 finished 同步发出，取消的下载也会调用 completion
+    QObject::connect(reply, &QNetworkReply::finished, reply, [this, taskId, reply, received, completion]() {
+        m_replies.remove(taskId);
+        const QNetworkReply::NetworkError error = reply->error();
+        const QByteArray data = *received + reply->readAll();
+
+        EXNetworkResponse response;
+        response.statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        response.eTag = reply->rawHeader("ETag");
+        response.lastModified = reply->rawHeader("Last-Modified");
+        response.cacheControl = reply->rawHeader("Cache-Control");
+        response.expires = reply->rawHeader("Expires");
+        response.date = reply->rawHeader("Date");
+        response.age = reply->rawHeader("Age");
+        response.acceptRanges = reply->rawHeader("Accept-Ranges");
+        response.contentRange = reply->rawHeader("Content-Range");
+        response.contentEncoding = reply->rawHeader("Content-Encoding");
+
+        reply->deleteLater();
+        if (completion) {
+            completion(data, error, response);
+        }
+    });
+}
+
+void EXNetworkEngine::_abortAll()
+{
+    // abort() 会在 finished 的回调中修改 m_replies，先拷贝
+    const auto replies = m_replies.values();
+    for (QNetworkReply* reply : replies) {
+        reply->abort();
+    }
+}
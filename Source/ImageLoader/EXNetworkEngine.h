@@ -0,0 +1,91 @@
+//
+//  EXNetworkEngine.h
+//
+//  Created by evanxlh on 2025/6/29.
+//
+
+#pragma once
+
+#include "EXImageLoaderGlobal.h"
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QThread>
+#include <QUrl>
+#include <atomic>
+#include <functional>
+
+// 与 HTTP 缓存有关的响应信息；没有收到响应(例如连接失败、取消)时 statusCode 为 0
+struct EXNetworkResponse
+{
+    int statusCode = 0;
+    QByteArray eTag;
+    QByteArray lastModified;
+    QByteArray cacheControl;
+    QByteArray expires;
+    QByteArray date;
+    QByteArray age;
+    QByteArray acceptRanges;
+    QByteArray contentRange;
+    QByteArray contentEncoding;
+};
+
+/**
+ 下载引擎: 所有下载共用一个长期存在的 QNetworkAccessManager，运行在专用的网络线程中。
+
+ 1. 连接复用: 同一个主机的连接在请求之间复用(HTTP/1.1 keep-alive，服务器支持时使用 HTTP/2 多路复用)，
+    DNS、TCP、TLS 的建立只在第一次请求时进行。
+ 2. 异步: 下载在网络线程的事件循环中进行，不占用工作线程，也没有嵌套的 QEventLoop。
+ 3. 回调在网络线程中调用，只应把数据交给其他线程(例如解码线程池)，不能做耗时的工作，否则会拖慢所有下载。
+
+ 所有公开方法都是线程安全的。
+ */
+class EXNetworkEngine
+{
+public:
+    using ProgressHandler = std::function<void(qint64 received, qint64 total)>;
+    // `error` 为 NoError 时 `data` 是完整的响应内容(304 时为空)；被 cancel() 取消时为 OperationCanceledError。
+    // 失败、取消时 `data` 是中断之前已收到的部分，可以用 Range 请求继续下载
+    using CompletionHandler = std::function<void(const QByteArray& data,
+                                                 QNetworkReply::NetworkError error,
+                                                 const EXNetworkResponse& response)>;
+    // 每次收到新数据时以目前收到的全部数据调用，用于边下载边解码；`data` 与引擎共享，拷贝很便宜
+    using PartialDataHandler = std::function<void(const QByteArray& data, qint64 total)>;
+    // 附加的请求头，例如条件请求的 If-None-Match、If-Modified-Since
+    using RawHeaders = QList<QPair<QByteArray, QByteArray>>;
+
+    EXNetworkEngine();
+    ~EXNetworkEngine();
+
+    EXNetworkEngine(const EXNetworkEngine&) = delete;
+    EXNetworkEngine& operator=(const EXNetworkEngine&) = delete;
+
+    // 开始下载，返回用于 cancel() 的编号；`completion` 每个下载只调用一次
+    quint64 get(const QUrl& url,
+                ImageLoader::Priority priority,
+                ProgressHandler progress,
+                CompletionHandler completion,
+                PartialDataHandler partialData = nullptr,
+                const RawHeaders& headers = RawHeaders());
+
+    void cancel(quint64 taskId);
+    void cancelAll();
+
+private:
+    void _start(quint64 taskId,
+                const QUrl& url,
+                ImageLoader::Priority priority,
+                const ProgressHandler& progress,
+                const CompletionHandler& completion,
+                const PartialDataHandler& partialData,
+                const RawHeaders& headers);
+    void _abortAll();
+
+private:
+    QThread m_thread;
+    QNetworkAccessManager* m_manager;           // 属于网络线程，随线程结束释放
+    QHash<quint64, QNetworkReply*> m_replies;   // 只在网络线程中访问
+    std::atomic<quint64> m_nextTaskId{ 1 };
+};
@@ -0,0 +1,180 @@
+//
+//  EXStreamingImageDecoder.cpp
+//
+//  Created by evanxlh on 2025/6/29.
+//
+
+#include "EXStreamingImageDecoder.h"
+#include <QIODevice>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <cstring>
+#include <utility>
+
+// 顺序读取的设备: 没有新的数据时读取等待，数据结束后读到结尾
+class EXStreamingImageDecoder::Device : public QIODevice
+{
+public:
+    explicit Device(EXStreamingImageDecoder* decoder) : m_decoder(decoder)
+    {
+        open(QIODevice::ReadOnly);
+    }
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override { return QIODevice::bytesAvailable() + m_decoder->_available(); }
+
+    // 已读完收到的数据、但下载还没结束时不是结尾
+    bool atEnd() const override { return QIODevice::bytesAvailable() == 0 && m_decoder->_atEnd(); }
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override { return m_decoder->_read(data, maxSize); }
+    qint64 writeData(const char*, qint64) override { return -1; }
+
+private:
+    EXStreamingImageDecoder* m_decoder;
+};
+
+EXStreamingImageDecoder::EXStreamingImageDecoder(qint64 frameInterval, FrameHandler frameHandler)
+    : m_frameInterval(frameInterval),
+    m_frameHandler(std::move(frameHandler))
+{
+}
+
+EXStreamingImageDecoder::~EXStreamingImageDecoder() = default;
+
+void EXStreamingImageDecoder::append(const QByteArray& data)
+{
+    if (data.isEmpty()) return;
+
+    QMutexLocker locker(&m_mutex);
+    if (m_finished || m_state == State::Finished || m_state == State::Abandoned) return;
+    m_data.append(data);
+    m_condition.wakeAll();
+}
+
+void EXStreamingImageDecoder::finish(bool complete)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_finished) return;
+    m_finished = true;
+    m_complete = complete;
+    m_condition.wakeAll();
+}
+
+void EXStreamingImageDecoder::abort()
+{
+    QMutexLocker locker(&m_mutex);
+    m_aborted = true;
+    m_finished = true;
+    m_condition.wakeAll();
+}
+
+void EXStreamingImageDecoder::decode()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_state != State::Pending || m_aborted) return;
+        m_state = State::Decoding;
+    }
+
+    Device device(this);
+    QImageReader reader(&device);
+    QImage image;
+
+    // 读取文件头(数据不够时等待)；基线 JPEG 先分配好图片，解码器把已解码的行直接写进去，
+    // 尺寸与格式一致时不会重新分配；还没解码的部分是白色
+    const QSize size = reader.size();
+    if (m_frameHandler && m_frameInterval > 0 && size.isValid() && reader.format() == "jpeg") {
+        QMutexLocker locker(&m_mutex);
+        if (!_isProgressiveJpeg()) {
+            image = QImage(size, reader.imageFormat());
+            if (!image.isNull()) {
+                image.fill(Qt::white);
+                m_frameSource = &image;
+                m_frameReadPosition = m_readPosition;
+            }
+        }
+    }
+
+    const bool decoded = reader.read(&image);
+
+    QMutexLocker locker(&m_mutex);
+    m_frameSource = nullptr;
+    m_result = decoded ? std::move(image) : QImage();
+    m_data = QByteArray();
+    m_state = State::Finished;
+    m_condition.wakeAll();
+}
+
+QImage EXStreamingImageDecoder::takeResult()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_state == State::Pending) {
+        m_state = State::Abandoned;
+        m_data = QByteArray();
+        return QImage();
+    }
+
+    while (m_state == State::Decoding) {
+        m_condition.wait(&m_mutex);
+    }
+    return m_complete && !m_aborted ? std::exchange(m_result, QImage()) : QImage();
+}
+
+qint64 EXStreamingImageDecoder::_read(char* data, qint64 maxSize)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // 追上了已收到的数据: 等待之前交出已解码的部分
+    if (m_frameSource && m_readPosition == m_data.size() && !m_finished
+        && m_readPosition - m_frameReadPosition >= m_frameInterval) {
+        m_frameReadPosition = m_readPosition;
+        const QImage frame = m_frameSource->copy();
+        locker.unlock();
+        m_frameHandler(frame);
+        locker.relock();
+    }
+
+    while (m_readPosition == m_data.size() && !m_finished) {
+        m_condition.wait(&m_mutex);
+    }
+    if (m_aborted) return -1;
+
+    const qint64 length = qMin(maxSize, static_cast<qint64>(m_data.size()) - m_readPosition);
+    std::memcpy(data, m_data.constData() + m_readPosition, static_cast<size_t>(length));
+    m_readPosition += length;
+    return length;
+}
+
+qint64 EXStreamingImageDecoder::_available() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_data.size() - m_readPosition;
+}
+
+bool EXStreamingImageDecoder::_atEnd() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_finished && m_readPosition == m_data.size();
+}
+
+bool EXStreamingImageDecoder::_isProgressiveJpeg() const
+{
+    // 跳过 SOI 之后的各个标记段，找到帧头 SOFn: SOF2、SOF6、SOF10、SOF14 是渐进式的
+    const auto byteAt = [this](qint64 position) { return static_cast<uchar>(m_data.at(position)); };
+    qint64 position = 2;
+    while (position + 4 <= m_data.size()) {
+        if (byteAt(position) != 0xFF) return false;
+
+        const uchar marker = byteAt(position + 1);
+        if (marker == 0xFF) {
+            ++position;
+            continue;
+        }
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            return marker == 0xC2 || marker == 0xC6 || marker == 0xCA || marker == 0xCE;
+        }
+        position += 2 + ((byteAt(position + 2) << 8) | byteAt(position + 3));
+    }
+    return false;
+}
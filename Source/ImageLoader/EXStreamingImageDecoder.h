@@ -0,0 +1,82 @@
+//
+//  EXStreamingImageDecoder.h
+//
+//  Created by evanxlh on 2025/6/29.
+//
+
+#pragma once
+
+#include <QByteArray>
+#include <QImage>
+#include <QMutex>
+#include <QWaitCondition>
+#include <functional>
+
+/**
+ 边下载边解码: decode() 在线程池中用一个 QImageReader 从顺序读取的设备中解码，
+ 设备中还没有数据时读取会等待 append()，下载结束时解码也随之结束，最终的图片不必再从头解码一遍。
+
+ 解码器追上已收到的数据、开始等待时，如果距上一次又读取了至少 `frameInterval` 字节，就把已解码的部分
+ 拷贝一份交给 `frameHandler`: 在解码线程中调用，此时解码器正在等待数据，不会同时写入图片。
+ 只有基线 JPEG 是按行解码的；渐进式 JPEG 与其他格式读完全部数据之前没有可用的行，不交出不完整的图片。
+
+ append()、finish() 在网络线程中调用，abort() 与 takeResult() 可以在任意线程中调用。
+ */
+class EXStreamingImageDecoder
+{
+public:
+    using FrameHandler = std::function<void(const QImage&)>;
+
+    EXStreamingImageDecoder(qint64 frameInterval, FrameHandler frameHandler);
+    ~EXStreamingImageDecoder();
+
+    // 收到的新数据
+    void append(const QByteArray& data);
+
+    // 下载结束，读完已收到的数据就是结尾；`complete` 为 false(失败、中断)时解码结果不可用。只有第一次调用有效
+    void finish(bool complete);
+
+    // 请求被取消: 正在等待的读取立即失败，解码尽快结束
+    void abort();
+
+    // 在线程池中执行，直到数据结束或被取消；takeResult() 已经放弃时直接返回
+    void decode();
+
+    /**
+     等待解码结束并取走结果，在 finish() 之后调用。
+     decode() 还没开始(在线程池中排队)时不等待它，之后它什么也不做；没有开始、数据不完整或解码失败时返回空的 QImage，
+     调用方应自己解码完整的数据
+     */
+    QImage takeResult();
+
+private:
+    class Device;
+
+    enum class State
+    {
+        Pending,    // decode() 还没开始
+        Decoding,
+        Finished,
+        Abandoned   // takeResult() 时还没开始，不再解码
+    };
+
+    qint64 _read(char* data, qint64 maxSize);
+    qint64 _available() const;
+    bool _atEnd() const;
+    bool _isProgressiveJpeg() const;
+
+    const qint64 m_frameInterval;
+    const FrameHandler m_frameHandler;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;         // 有新的数据、数据结束、被取消或解码结束
+    QByteArray m_data;                  // 收到的全部数据，解码结束后释放
+    qint64 m_readPosition = 0;
+    bool m_finished = false;
+    bool m_complete = false;
+    bool m_aborted = false;
+    State m_state = State::Pending;
+    QImage m_result;
+    const QImage* m_frameSource = nullptr;  // 正在解码的图片，可以交出不完整的图片时才设置
+    qint64 m_frameReadPosition = 0;         // 上次交出不完整的图片时已读取的字节数
+};
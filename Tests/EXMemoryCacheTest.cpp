@@ -0,0 +1,245 @@
+//
+//  EXMemoryCacheTest.cpp
+//
+//  Created by evanxlh on 2025/7/6.
+//
+
+#include "../Source/Cache/EXMemoryCache.h"
+
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+/**
+ EXMemoryCache 的回归测试(不依赖 Qt):
+   - 插入/删除交替进行时，开放寻址表的探测链保持完整(删除使用后移，不留墓碑)
+   - 被 Handle 钉住的缓存项被淘汰或 clear() 之后仍然可读，totalCost 在 Handle 释放时才扣除
+   - setLimits() 缩小限制时按 trimBatchSize 分批淘汰
+   - W-TinyLFU 在 cost/count 限制切换前后插入的缓存项都按各自插入时的权重扣除
+ */
+
+static int failures = 0;
+
+#define EXPECT(condition, ...)                          \
+    do {                                                \
+        if (!(condition) && ++failures <= 20) {         \
+            std::printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            std::printf(__VA_ARGS__);                   \
+            std::printf("\n");                          \
+        }                                               \
+    } while (0)
+
+// 只有 16 种哈希值的 key: 大量 key 落在同一个起始槽位，形成跨越表尾的长探测簇
+struct CollidingKey
+{
+    int value;
+
+    bool operator==(const CollidingKey& other) const { return value == other.value; }
+};
+
+namespace std {
+template <>
+struct hash<CollidingKey>
+{
+    size_t operator()(const CollidingKey& key) const { return static_cast<size_t>(key.value & 15); }
+};
+}
+
+// 随机插入、替换、删除，与 std::unordered_map 对照: 每一步之后所有 key 都要查得到，删除的 key 都查不到
+static void testProbeChains()
+{
+    using Cache = EXMemoryCache<CollidingKey, int>;
+    std::mt19937 random(20250615);
+
+    for (int round = 0; round < 20; ++round) {
+        Cache cache;
+        std::unordered_map<int, int> expected;
+        const int keySpace = 64 + round * 16;
+
+        for (int step = 0; step < 4000; ++step) {
+            const int key = static_cast<int>(random() % keySpace);
+            if (random() % 3 == 0) {
+                const bool removed = cache.remove(CollidingKey{ key });
+                EXPECT(removed == (expected.erase(key) > 0), "remove(%d) returned %d", key, removed);
+            } else {
+                cache.put(CollidingKey{ key }, step);
+                expected[key] = step;
+            }
+
+            if (step % 50 != 0) continue;
+            for (int k = 0; k < keySpace; ++k) {
+                const auto value = cache.get(CollidingKey{ k });
+                const auto it = expected.find(k);
+                if (it == expected.end()) {
+                    EXPECT(!value, "round %d: removed key %d still found", round, k);
+                } else {
+                    EXPECT(value && *value == it->second, "round %d: key %d lost after %d steps", round, k, step);
+                }
+            }
+            EXPECT(cache.count() == expected.size(), "count %zu, expected %zu", cache.count(), expected.size());
+        }
+    }
+}
+
+// 被钉住的缓存项被淘汰、删除、清空之后仍然可读，节点与 cost 保留到 Handle 释放
+static void testPinnedEntries()
+{
+    using Cache = EXMemoryCache<int, int>;
+    Cache::Config config;
+    config.costLimit = 100;
+    Cache cache(config);
+
+    for (int i = 0; i < 10; ++i) {
+        cache.put(i, i * 10, 10);
+    }
+    auto evicted = cache.pin(0);
+    auto removed = cache.pin(1);
+    EXPECT(evicted && *evicted == 0 && removed && *removed == 10, "pin() missed cached entries");
+    for (int i = 2; i < 10; ++i) {
+        cache.get(i);
+    }
+
+    // 被淘汰的 0 与被删除的 1 不再命中，但它们的 cost 仍计入 totalCost，且不挤占其他缓存项
+    cache.put(10, 100, 10);
+    cache.remove(1);
+    EXPECT(!cache.contains(0) && !cache.contains(1), "evicted or removed entries are still found");
+    EXPECT(*evicted == 0 && *removed == 10, "pinned values changed after eviction");
+    EXPECT(cache.count() == 9, "count %zu after eviction, expected 9", cache.count());
+    EXPECT(cache.totalCost() == 110, "totalCost %zu with two pinned entries, expected 110", cache.totalCost());
+
+    cache.put(11, 110, 10);
+    EXPECT(cache.count() == 10 && cache.contains(11), "pinned entries took space from live entries");
+
+    evicted.reset();
+    EXPECT(cache.totalCost() == 110, "totalCost %zu after releasing one handle, expected 110", cache.totalCost());
+    removed.reset();
+    EXPECT(cache.totalCost() == 100, "totalCost %zu after releasing both handles, expected 100", cache.totalCost());
+
+    // clear() 之后钉住的缓存项仍然可读，其余的立即释放
+    auto cleared = cache.pin(5);
+    cache.clear();
+    EXPECT(cache.count() == 0 && !cache.contains(5), "clear() left entries in the cache");
+    EXPECT(cleared && *cleared == 50, "pinned value changed after clear()");
+    EXPECT(cache.totalCost() == 10, "totalCost %zu after clear() with one pinned entry, expected 10", cache.totalCost());
+
+    cache.put(5, 500, 10);
+    EXPECT(cache.get(5) == 500 && *cleared == 50, "re-inserted key shares the pinned node");
+    cleared.reset();
+    EXPECT(cache.totalCost() == 10, "totalCost %zu after releasing the cleared entry, expected 10", cache.totalCost());
+}
+
+// setLimits() 缩小限制: 每批最多 trimBatchSize 项，返回时已满足新的限制
+static void testSetLimitsBatches()
+{
+    using Cache = EXMemoryCache<int, int>;
+    Cache::Config config;
+    config.countLimit = 1000;
+    config.trimBatchSize = 64;
+    Cache cache(config);
+
+    for (int i = 0; i < 1000; ++i) {
+        cache.put(i, i);
+    }
+
+    std::vector<size_t> batches;
+    cache.setRemovalListener([&](std::vector<Cache::Removal>& removals) {
+        batches.push_back(removals.size());
+        for (const auto& removal : removals) {
+            EXPECT(removal.cause == EXCacheRemovalCause::Capacity, "key %d removed for a reason other than capacity", removal.key);
+        }
+    });
+    cache.setLimits(0, 100);
+
+    size_t total = 0;
+    for (size_t batch : batches) {
+        EXPECT(batch <= config.trimBatchSize, "trimmed %zu entries in one batch, limit %zu", batch, config.trimBatchSize);
+        total += batch;
+    }
+    EXPECT(total == 900 && batches.size() >= 900 / config.trimBatchSize, "trimmed %zu entries in %zu batches", total, batches.size());
+    EXPECT(cache.count() == 100, "count %zu after setLimits(), expected 100", cache.count());
+
+    // LRU: 留下的是最近插入的 100 项
+    for (int i = 900; i < 1000; ++i) {
+        EXPECT(cache.contains(i), "recent key %d was trimmed", i);
+    }
+}
+
+using TinyLFUCache = EXMemoryCache<int, int, EXCacheNoLock, EXCacheNoTTL, EXCacheTinyLFUPolicy>;
+
+// 访问 100 个热点 key 之后扫描一遍大量新 key，返回仍留在缓存中的热点数量
+static int hotKeysAfterScan(TinyLFUCache& cache, int firstKey, size_t cost)
+{
+    for (int round = 0; round < 8; ++round) {
+        for (int key = firstKey; key < firstKey + 100; ++key) {
+            if (!cache.get(key)) {
+                cache.put(key, key, cost);
+            }
+        }
+    }
+    for (int key = firstKey + 100000; key < firstKey + 110000; ++key) {
+        cache.put(key, key, cost);
+    }
+
+    int survivors = 0;
+    for (int key = firstKey; key < firstKey + 100; ++key) {
+        survivors += cache.contains(key) ? 1 : 0;
+    }
+    return survivors;
+}
+
+// 在 cost 与 count 限制之间切换，旧缓存项按插入时的权重退出；之后窗口与保护区的配额仍然有效
+static void testTinyLFUWeights()
+{
+    TinyLFUCache::Config config;
+    config.costLimit = 2000;
+    TinyLFUCache cache(config);
+
+    int hot = hotKeysAfterScan(cache, 0, 10);
+    EXPECT(hot >= 90, "cost limit: only %d of 100 hot keys survived the scan", hot);
+
+    // cost 限制 -> count 限制: 已有的缓存项仍按 cost 权重退出，新缓存项权重为 1
+    cache.setLimits(0, 200);
+    EXPECT(cache.count() <= 200, "count %zu over the new count limit", cache.count());
+    hot = hotKeysAfterScan(cache, 1000000, 7);
+    EXPECT(hot >= 90, "after switching to a count limit only %d of 100 hot keys survived the scan", hot);
+
+    // count 限制 -> cost 限制
+    cache.setLimits(3000, 0);
+    EXPECT(cache.totalCost() <= 3000, "totalCost %zu over the new cost limit", cache.totalCost());
+    hot = hotKeysAfterScan(cache, 2000000, 15);
+    EXPECT(hot >= 90, "after switching back to a cost limit only %d of 100 hot keys survived the scan", hot);
+
+    // 所有缓存项退出之后窗口、试用区、保护区都是空的，重新填充与全新的缓存一样
+    std::vector<int> keys;
+    cache.forEach([&](int key, int) { keys.push_back(key); });
+    EXPECT(keys.size() == cache.count(), "forEach visited %zu entries, count %zu", keys.size(), cache.count());
+    for (int key : keys) {
+        cache.remove(key);
+    }
+    EXPECT(cache.count() == 0 && cache.totalCost() == 0, "count %zu, totalCost %zu after removing every entry", cache.count(), cache.totalCost());
+
+    cache.setLimits(0, 50);
+    for (int key = 0; key < 50; ++key) {
+        cache.put(key, key);
+    }
+    EXPECT(cache.count() == 50, "refilled cache holds %zu of 50 entries", cache.count());
+    for (int key = 0; key < 50; ++key) {
+        EXPECT(cache.contains(key), "key %d evicted while the cache was not full", key);
+    }
+}
+
+int main()
+{
+    testProbeChains();
+    testPinnedEntries();
+    testSetLimitsBatches();
+    testTinyLFUWeights();
+
+    if (failures > 0) {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all memory cache checks passed\n");
+    return 0;
+}
@@ -0,0 +1,145 @@
+//
+//  EXTimingWheelTest.cpp
+//
+//  Created by evanxlh on 2025/7/6.
+//
+
+#include "../Source/Cache/EXTimingWheel.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/**
+ EXTimingWheel 的回归测试(不依赖 Qt): 每个节点必须恰好在到期 tick 触发。
+
+ 逐个 tick 推进时间轮，记录每个节点触发时的 tick，与 max(到期 tick, 登记后的下一个 tick) 比较。
+ 到期时间覆盖每一层的边界(64^L 前后)，登记的起点覆盖各层槽位转动的位置，cascade 时重新分配的节点也要准时。
+ */
+
+struct Nodes
+{
+    std::vector<EXTimingWheelLinks> links;
+    std::vector<uint64_t> deadlines;
+
+    EXTimingWheelLinks& wheelLinks(uint32_t index) { return links[index]; }
+    uint64_t deadlineTick(uint32_t index) { return deadlines[index]; }
+
+    uint32_t add(uint64_t deadline)
+    {
+        links.push_back({ 0, 0, EXTimingWheel<Nodes>::NoSlot });
+        deadlines.push_back(deadline);
+        return static_cast<uint32_t>(deadlines.size() - 1);
+    }
+};
+
+static int failures = 0;
+
+// 从 `start` 开始登记 `deadlines`，逐个 tick 推进到全部触发
+static void runCase(uint64_t start, const std::vector<uint64_t>& deadlines)
+{
+    Nodes nodes;
+    EXTimingWheel<Nodes> wheel;
+    wheel.reset(start);
+
+    std::vector<uint64_t> expected;
+    for (uint64_t deadline : deadlines) {
+        wheel.schedule(nodes, nodes.add(deadline));
+        expected.push_back(deadline > start ? deadline : start + 1);
+    }
+
+    std::vector<uint64_t> fired(deadlines.size(), 0);
+    uint64_t now = start;
+    while (wheel.size() > 0) {
+        ++now;
+        wheel.advance(nodes, now, 0, [&](uint32_t index) { fired[index] = now; });
+    }
+
+    for (size_t i = 0; i < deadlines.size(); ++i) {
+        if (fired[i] != expected[i]) {
+            if (++failures <= 20) {
+                std::printf("FAIL start=%llu deadline=%llu expected=%llu fired=%llu\n",
+                            static_cast<unsigned long long>(start), static_cast<unsigned long long>(deadlines[i]),
+                            static_cast<unsigned long long>(expected[i]), static_cast<unsigned long long>(fired[i]));
+            }
+        }
+    }
+}
+
+// 每一层的边界: 距起点 64^L - 1、64^L、64^L + 1，以及与起点对齐的 tick 前后
+static void testLevelBoundaries()
+{
+    using Wheel = EXTimingWheel<Nodes>;
+    const uint64_t starts[] = { 0, 1, 62, 63, 64, 65, 4095, 4096, 4097, 262143, 262144, 1000003 };
+
+    for (uint64_t start : starts) {
+        std::vector<uint64_t> deadlines = { 0, start, start + 1, start + 2 };
+        for (int level = 1; level <= Wheel::Levels; ++level) {
+            const uint64_t span = uint64_t(1) << (Wheel::SlotBits * level);
+            for (uint64_t distance : { span - 1, span, span + 1, 2 * span - 1, 2 * span }) {
+                deadlines.push_back(start + distance);
+            }
+            // 与层边界对齐的绝对 tick: cascade 到这一层槽位的前后
+            const uint64_t aligned = (start / span + 1) * span;
+            for (uint64_t offset : { uint64_t(0), uint64_t(1), span - 1 }) {
+                deadlines.push_back(aligned + offset);
+                deadlines.push_back(aligned - 1 + offset);
+            }
+        }
+        runCase(start, deadlines);
+    }
+}
+
+// 随机的起点与到期时间，推进过程中继续登记
+static void testRandomized()
+{
+    std::mt19937_64 random(20250706);
+    for (int round = 0; round < 20; ++round) {
+        Nodes nodes;
+        EXTimingWheel<Nodes> wheel;
+        const uint64_t start = random() % 100000;
+        wheel.reset(start);
+
+        std::vector<uint64_t> expected;
+        std::vector<uint64_t> fired;
+        uint64_t now = start;
+        const auto scheduleRandom = [&](int count) {
+            for (int i = 0; i < count; ++i) {
+                const uint64_t distance = random() % (uint64_t(1) << (6 * (1 + random() % 3)));
+                const uint64_t deadline = now + distance;
+                wheel.schedule(nodes, nodes.add(deadline));
+                expected.push_back(deadline > now ? deadline : now + 1);
+                fired.push_back(0);
+            }
+        };
+
+        scheduleRandom(2000);
+        while (wheel.size() > 0) {
+            ++now;
+            wheel.advance(nodes, now, 0, [&](uint32_t index) { fired[index] = now; });
+            if (now - start < 20000 && now % 97 == 0) {
+                scheduleRandom(20);
+            }
+        }
+
+        for (size_t i = 0; i < expected.size(); ++i) {
+            if (fired[i] != expected[i] && ++failures <= 20) {
+                std::printf("FAIL random round=%d deadline=%llu fired=%llu\n", round,
+                            static_cast<unsigned long long>(expected[i]), static_cast<unsigned long long>(fired[i]));
+            }
+        }
+    }
+}
+
+int main()
+{
+    testLevelBoundaries();
+    testRandomized();
+
+    if (failures > 0) {
+        std::printf("%d timer(s) fired on the wrong tick\n", failures);
+        return 1;
+    }
+    std::printf("all timers fired on their deadline tick\n");
+    return 0;
+}
@@ -6,14 +6,22 @@
 
 #include "MainWindow.h"
 #include "Source/Cache/EXMemoryCache.h"
+#include "Source/Cache/EXMemoryCacheSnapshot.h"
 #include "Source/ImageLoader/EXImageLoader.h"
 #include "Source/ImageLoader/EXImageProcessor.h"
 
 #include <QApplication>
 #include <QLabel>
+#include <QImage>
+#include <QPainter>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
 #include <iostream>
 #include <memory>
 #include <chrono>
+#include <vector>
+#include <random>
+#include <numeric>
 
 // 测试对象类
 class TestObject {
@@ -37,14 +45,14 @@ void testValueCache()
 
     srand(static_cast<unsigned>(time(nullptr)));
 
-    EXMemoryCache<int, std::string>::Config config;
+    using Cache = EXMemoryCache<int, std::string, EXCacheNoLock, EXCacheNoTTL>;
+
+    Cache::Config config;
     config.costLimit = 500 * 1024 * 1024; // 100MB
     config.countLimit = 1000000;
-    config.enablesThreadSafe = false;
-    config.enablesTTL = false;
     config.defaultTTL = 60; // 默认60秒过期
 
-    EXMemoryCache<int, std::string> cache(config);
+    Cache cache(config);
 
     const int numItems = 1000000;
     auto start = std::chrono::high_resolution_clock::now();
@@ -85,14 +93,14 @@ void testSharedPtrCache() {
 
     srand(static_cast<unsigned>(time(nullptr)));
 
-    EXMemoryCache<int, std::shared_ptr<TestObject>>::Config config;
+    using Cache = EXMemoryCache<int, std::shared_ptr<TestObject>, EXCacheMutexLock, EXCacheLazyTTL>;
+
+    Cache::Config config;
     config.costLimit = 500 * 1024 * 1024; // 200MB
     config.countLimit = 1000000;
-    config.enablesThreadSafe = true;
-    config.enablesTTL = true;
     config.defaultTTL = 60; // 默认60秒过期
 
-    EXMemoryCache<int, std::shared_ptr<TestObject>> cache(config);
+    Cache cache(config);
 
     const int numItems = 1000000;
     auto start = std::chrono::high_resolution_clock::now();
@@ -147,6 +155,131 @@ void testSharedPtrCache() {
     std::cout << "外部引用销毁后，对象自动释放\n";
 }
 
+// 单线程 put/get 延迟
+template <typename Cache>
+void measureCacheLatency(const char* name)
+{
+    const int numItems = 1000000;
+    typename Cache::Config config;
+    config.countLimit = numItems;
+    Cache cache(config);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < numItems; ++i) {
+        cache.put(i, i, sizeof(int));
+    }
+    auto middle = std::chrono::high_resolution_clock::now();
+
+    std::mt19937 rng(1);
+    int hits = 0;
+    for (int i = 0; i < numItems; ++i) {
+        if (cache.get(static_cast<int>(rng() % numItems))) {
+            hits++;
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << "  " << name << ": 节点 " << Cache::entrySize() << " 字节, "
+              << "put " << std::chrono::duration<double, std::nano>(middle - start).count() / numItems << " ns, "
+              << "get " << std::chrono::duration<double, std::nano>(end - middle).count() / numItems << " ns"
+              << " (命中 " << hits << ")\n";
+}
+
+// 不同编译期策略组合的节点大小与单线程延迟
+void testCachePolicies()
+{
+    std::cout << "\n=== 测试缓存策略组合 (int -> int) ===\n";
+
+    measureCacheLatency<EXMemoryCache<int, int, EXCacheNoLock, EXCacheNoTTL>>("NoLock + NoTTL");
+    measureCacheLatency<EXMemoryCache<int, int, EXCacheSpinLock, EXCacheNoTTL>>("SpinLock + NoTTL");
+    measureCacheLatency<EXMemoryCache<int, int, EXCacheMutexLock, EXCacheNoTTL>>("Mutex + NoTTL");
+    measureCacheLatency<EXMemoryCache<int, int, EXCacheMutexLock, EXCacheLazyTTL>>("Mutex + LazyTTL");
+    measureCacheLatency<EXMemoryCache<int, int, EXCacheMutexLock, EXCacheWheelTTL>>("Mutex + WheelTTL");
+}
+
+// 模拟滚动时一屏 60 个缩略图的查找: 逐个 get 与 getMany 的对比
+void testBatchCache()
+{
+    std::cout << "\n=== 测试批量查找 (int -> std::string, 每批 60 个 key) ===\n";
+
+    const int keySpace = 100000;
+    const int batchSize = 60;
+    const int rounds = 50000;
+
+    EXMemoryCache<int, std::string>::Config config;
+    config.countLimit = keySpace;
+    EXMemoryCache<int, std::string> cache(config);
+    for (int i = 0; i < keySpace; ++i) {
+        cache.put(i, "Value for key: " + std::to_string(i));
+    }
+
+    std::vector<int> keys(batchSize);
+    std::vector<std::optional<std::string>> results;
+    results.reserve(batchSize);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        std::iota(keys.begin(), keys.end(), (round * batchSize) % (keySpace - batchSize));
+        results.clear();
+        for (int key : keys) {
+            results.push_back(cache.get(key));
+        }
+    }
+    auto middle = std::chrono::high_resolution_clock::now();
+
+    for (int round = 0; round < rounds; ++round) {
+        std::iota(keys.begin(), keys.end(), (round * batchSize) % (keySpace - batchSize));
+        results.clear();
+        cache.getMany(keys, std::back_inserter(results));
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    const double lookups = double(rounds) * batchSize;
+    std::cout << "  逐个 get: " << std::chrono::duration<double, std::nano>(middle - start).count() / lookups << " ns/key\n"
+              << "  getMany: " << std::chrono::duration<double, std::nano>(end - middle).count() / lookups << " ns/key\n";
+}
+
+// 启动后第一屏(60 张 200x200 缩略图)的加载耗时: 从磁盘缓存解码 PNG 与从内存缓存快照取出的对比
+void testCacheSnapshot()
+{
+    std::cout << "\n=== 测试内存缓存快照 (60 张 200x200 缩略图) ===\n";
+
+    const int screenful = 60;
+    QTemporaryDir dir;
+    EXMemoryCache<QString, QPixmap> cache;
+    for (int i = 0; i < screenful; ++i) {
+        QImage image(200, 200, QImage::Format_ARGB32_Premultiplied);
+        image.fill(QColor::fromHsv(i * 6, 200, 220));
+        QPainter(&image).drawEllipse(20, 20, 160, 160);
+
+        const QString key = QString("thumbnail_%1").arg(i);
+        image.save(dir.filePath(key + ".png"));
+        cache.put(key, QPixmap::fromImage(image));
+    }
+    const QString snapshotPath = dir.filePath("memory_cache.snapshot");
+    EXMemoryCacheSnapshot<QString, QPixmap>::save(snapshotPath, cache);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < screenful; ++i) {
+        const QPixmap pixmap = QPixmap::fromImage(QImage(dir.filePath(QString("thumbnail_%1.png").arg(i))));
+        Q_UNUSED(pixmap);
+    }
+    const qint64 diskNanoseconds = timer.nsecsElapsed();
+
+    timer.restart();
+    EXMemoryCacheSnapshot<QString, QPixmap> snapshot;
+    snapshot.open(snapshotPath);
+    for (int i = 0; i < screenful; ++i) {
+        const auto pixmap = snapshot.take(QString("thumbnail_%1").arg(i));
+        Q_UNUSED(pixmap);
+    }
+    const qint64 snapshotNanoseconds = timer.nsecsElapsed();
+
+    std::cout << "  磁盘缓存(PNG 解码): " << diskNanoseconds / 1e6 << " ms\n"
+              << "  内存缓存快照(含 open): " << snapshotNanoseconds / 1e6 << " ms\n";
+}
+
 void testImageLoader()
 {
     QLabel* label = new QLabel();
@@ -201,6 +334,9 @@ int main(int argc, char *argv[])
     testImageLoader();
     // testValueCache();
     // testSharedPtrCache();
+    // testCachePolicies();
+    // testBatchCache();
+    // testCacheSnapshot();
 
     return a.exec();
 }